@@ -0,0 +1,146 @@
+/*
+  A simulated board on the far end of the driver's pins. See HostBoard.h
+*/
+
+#include "Arduino.h"
+#include "HostSim.h"
+#include "ATtinyTimer.h"
+#include "NovaDotMatrix.h"
+#include "HostBoard.h"
+
+extern NovaDotMatrix novadotmatrix;
+
+uint32_t host_board_bytes;
+uint32_t host_board_lost;
+void (*host_board_byte_hook)(uint8_t);
+
+static uint8_t board_clk_pin, board_data_pin, board_diag_pin;
+static uint64_t board_now_us; // runs ahead of host_now_us while the board is stuck in a wait
+static uint64_t next_tick_us, next_loop_us;
+
+// what PB1 did, for reading it back at the host's time
+#define HOST_BOARD_EDGES 4096 // a profile answer is about 700
+static uint64_t edge_us[HOST_BOARD_EDGES];
+static uint8_t edge_level[HOST_BOARD_EDGES];
+static uint16_t edges;
+
+void HostBoardStart(uint8_t clk_pin, uint8_t data_pin, uint8_t diag_pin) {
+  board_clk_pin  = clk_pin;
+  board_data_pin = data_pin;
+  board_diag_pin = diag_pin;
+  host_board_bytes = host_board_lost = 0;
+
+  // power up with nothing attached, so its start up delays just pass
+  host_pin_hook  = 0;
+  host_read_hook = 0;
+  host_port_hook = 0;
+  host_time_hook = 0;
+  PINB = 0; // master is there, holding data low. no demo
+  novadotmatrix.Setup();
+
+  edges = 0;
+  board_now_us = host_now_us;
+  next_tick_us = host_now_us + HOST_TICK_US;
+  next_loop_us = host_now_us;
+  host_pin_hook  = HostBoardPin;
+  host_read_hook = HostBoardRead;
+  host_port_hook = HostBoardPort;
+  host_time_hook = HostBoardTime;
+}
+
+void HostBoardRx(uint8_t c) {
+  novadotmatrix.indata = c;
+  novadotmatrix.indata_available = true;
+  novadotmatrix.ProcessInData();
+}
+
+void HostBoardPin(uint8_t pin, uint8_t val) {
+  bool had;
+
+  if (pin == board_data_pin) {
+    if (val)
+      PINB |= NDOTM_DAT_IN_BIT;
+    else
+      PINB &= ~NDOTM_DAT_IN_BIT;
+  }
+  if (pin != board_clk_pin)
+    return;
+
+  if (val)
+    PINB |= NDOTM_CLK_IN_BIT;
+  else
+    PINB &= ~NDOTM_CLK_IN_BIT;
+
+  if (!(PCMSK & NDOTM_CLK_IN_BIT) || !(GIMSK & 0b00100000))
+    return;
+  had = novadotmatrix.indata_available;
+  if (val && had)
+    host_board_lost++;
+  PCINT0_vect();
+  if (!had && novadotmatrix.indata_available) {
+    host_board_bytes++;
+    if (host_board_byte_hook)
+      host_board_byte_hook(novadotmatrix.indata);
+  }
+}
+
+void HostBoardPort(uint8_t was, uint8_t now) {
+  // keep PB1's changes in time order. the ISR can set it at the host's
+  // time while the board's own clock is further on
+  uint16_t i;
+
+  if (!((was ^ now) & NDOTM_DAT_OUT_BIT))
+    return;
+  if (edges == HOST_BOARD_EDGES) {
+    memmove(edge_us, edge_us + 1, sizeof(edge_us[0]) * (HOST_BOARD_EDGES - 1));
+    memmove(edge_level, edge_level + 1, HOST_BOARD_EDGES - 1);
+    edges--;
+  }
+  for (i = edges; i > 0 && edge_us[i - 1] > host_now_us; i--) {
+    edge_us[i]    = edge_us[i - 1];
+    edge_level[i] = edge_level[i - 1];
+  }
+  edge_us[i]    = host_now_us;
+  edge_level[i] = (now & NDOTM_DAT_OUT_BIT) ? HIGH : LOW;
+  edges++;
+}
+
+int HostBoardRead(uint8_t pin) {
+  // PB1 as it was at the host's time
+  uint16_t i;
+
+  if (pin != board_diag_pin)
+    return -1;
+  for (i = edges; i > 0; i--) {
+    if (edge_us[i - 1] <= host_now_us)
+      return edge_level[i - 1];
+  }
+  return edges ? !edge_level[0] : ((PORTB & NDOTM_DAT_OUT_BIT) ? HIGH : LOW);
+}
+
+void HostBoardTime(uint64_t until) {
+  //
+  // timer interrupts and trips round the main loop, in time order, on
+  // the board's clock. When the board waits (diag output), only its
+  // clock moves, and it sits out the host's waits until they catch up.
+  //
+  uint64_t host_us = host_now_us;
+
+  if (host_now_us < board_now_us)
+    host_now_us = board_now_us;
+  while (next_tick_us <= until || next_loop_us <= until) {
+    if (next_tick_us <= next_loop_us) {
+      if (host_now_us < next_tick_us)
+        host_now_us = next_tick_us;
+      TIMER1_OVF_vect();
+      next_tick_us += HOST_TICK_US;
+    } else {
+      if (host_now_us < next_loop_us)
+        host_now_us = next_loop_us;
+      novadotmatrix.Loop();
+      next_loop_us = host_now_us + HOST_LOOP_US;
+    }
+  }
+  board_now_us = host_now_us;
+  host_now_us  = host_us;
+}
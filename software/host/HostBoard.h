@@ -0,0 +1,42 @@
+/*
+  A simulated board on the far end of the driver's pins
+
+  HostBoardStart() powers up novadotmatrix and wires it to three host pins:
+  clock and data from the driver, and the board's PB1 back on the diag pin.
+  From then on, whenever anything waits, the board runs: its Timer1
+  interrupt every HOST_TICK_US and its Loop() every HOST_LOOP_US. A rising
+  clock calls ISR(PCINT0_vect) straight away, so the board never misses
+  an edge. It can still miss a byte, if its main loop hasn't taken the one
+  before.
+
+  The board keeps its own clock. When it waits (sending diagnostics), that
+  clock runs on ahead and the board sits out the host's time until it
+  catches up. Reads of the diag pin see PB1 as it was at the host's time.
+
+  PCINT receive only. A board built with NDOTM_RX_USI isn't modelled.
+
+  HostBoardRx() skips the wires and hands the board a byte, the way the
+  demo talks to itself.
+*/
+
+#ifndef HostBoard_h
+#define HostBoard_h
+#include <stdint.h>
+
+#define HOST_TICK_US 2048 // Timer1 overflow, as ATtinyTimer::Setup() sets it
+#define HOST_LOOP_US 20   // time round the board's main loop
+
+void HostBoardStart(uint8_t, uint8_t, uint8_t); // clock, data, diag pins
+void HostBoardRx(uint8_t);
+
+// the hooks HostBoardStart() puts in, for anyone who wants to wrap them
+void HostBoardPin(uint8_t, uint8_t);
+void HostBoardPort(uint8_t, uint8_t);
+int  HostBoardRead(uint8_t);
+void HostBoardTime(uint64_t);
+
+extern uint32_t host_board_bytes; // bytes the board has had
+extern uint32_t host_board_lost;  // clock edges ignored because the last byte wasn't taken
+extern void (*host_board_byte_hook)(uint8_t); // each byte as it lands
+
+#endif // HostBoard_h
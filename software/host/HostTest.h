@@ -0,0 +1,23 @@
+/*
+  Checks for the host tests. One test program per file, run by ctest.
+*/
+
+#ifndef HostTest_h
+#define HostTest_h
+#include <stdio.h>
+
+static int host_test_fails;
+
+#define CHECK(x) do { \
+  if (!(x)) { \
+    printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #x); \
+    host_test_fails++; \
+  } \
+} while (0)
+
+static inline int HostTestDone(const char *name) {
+  printf("%s: %s\n", name, host_test_fails ? "FAILED" : "ok");
+  return host_test_fails ? 1 : 0;
+}
+
+#endif // HostTest_h
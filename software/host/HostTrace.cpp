@@ -0,0 +1,160 @@
+/*
+  A logic analyser on a HostBoard. See HostTrace.h
+*/
+
+#include <stdio.h>
+#include <algorithm>
+#include "Arduino.h"
+#include "HostSim.h"
+#include "HostBoard.h"
+#include "HostTrace.h"
+#include "NovaDotMatrix.h"
+#include "NovaDotMatrixCommands.h"
+
+#define HOST_TRACE_MAX (1 << 20) // events
+
+HostTraceEvent *host_trace;
+uint32_t host_trace_len;
+
+static void (*board_pin_hook)(uint8_t, uint8_t);
+static void (*board_port_hook)(uint8_t, uint8_t);
+static void (*board_byte_hook)(uint8_t);
+static uint64_t last_us;
+static uint16_t same_us;
+static bool after_escape;
+
+static const struct {
+  uint8_t cmd;
+  const char *name;
+} names[] = {
+  {ndotm_cmd_reset, "reset"}, {ndotm_cmd_message, "message"}, {ndotm_cmd_flip, "flip"},
+  {ndotm_cmd_noflip, "noflip"}, {ndotm_cmd_font, "font"}, {ndotm_cmd_dwell, "dwell"},
+  {ndotm_cmd_rate, "rate"}, {ndotm_cmd_transition, "transition"}, {ndotm_cmd_data, "data"},
+  {ndotm_cmd_data_scroll, "data_scroll"}, {ndotm_cmd_char, "char"}, {ndotm_cmd_shift_dir, "shift_dir"},
+  {ndotm_cmd_2ch, "2ch"}, {ndotm_cmd_2ch_flipped, "2ch_flipped"}, {ndotm_cmd_col, "col"},
+  {ndotm_cmd_cols, "cols"}, {ndotm_cmd_pixels, "pixels"}, {ndotm_cmd_packet, "packet"},
+  {ndotm_cmd_diag, "diag"}, {ndotm_cmd_counter, "counter"}, {ndotm_cmd_count_up, "count_up"},
+  {ndotm_cmd_count_down, "count_down"}, {ndotm_cmd_count_add, "count_add"},
+  {ndotm_cmd_playlist_store, "playlist_store"}, {ndotm_cmd_playlist, "playlist"},
+  {ndotm_cmd_glyph, "glyph"}, {ndotm_cmd_canvas, "canvas"}, {ndotm_cmd_view, "view"},
+  {ndotm_cmd_pan, "pan"}, {ndotm_cmd_drift, "drift"}, {ndotm_cmd_scroll_dir, "scroll_dir"},
+  {ndotm_cmd_transition_fx, "transition_fx"}, {ndotm_cmd_effect, "effect"},
+};
+
+const char *HostTraceCommandName(uint8_t cmd) {
+  for (uint8_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+    if (names[i].cmd == cmd)
+      return names[i].name;
+  }
+  return "unknown";
+}
+
+static void Record(uint8_t signal, uint8_t value) {
+  if (!host_trace || host_trace_len == HOST_TRACE_MAX)
+    return;
+  if (host_now_us != last_us) {
+    last_us = host_now_us;
+    same_us = 0;
+  } else if (same_us < 999) {
+    same_us++;
+  }
+  host_trace[host_trace_len].ns     = host_now_us * 1000 + same_us;
+  host_trace[host_trace_len].signal = signal;
+  host_trace[host_trace_len].value  = value;
+  host_trace_len++;
+}
+
+static void TracePin(uint8_t pin, uint8_t val) {
+  uint8_t was = PINB, now;
+
+  board_pin_hook(pin, val);
+  now = PINB;
+  if ((was ^ now) & NDOTM_DAT_IN_BIT)
+    Record(host_trace_dat_in, (now & NDOTM_DAT_IN_BIT) ? 1 : 0);
+  if ((was ^ now) & NDOTM_CLK_IN_BIT)
+    Record(host_trace_clk_in, (now & NDOTM_CLK_IN_BIT) ? 1 : 0);
+}
+
+static void TracePort(uint8_t was, uint8_t now) {
+  board_port_hook(was, now);
+  if ((was ^ now) & NDOTM_SR_DAT_BIT)
+    Record(host_trace_sr_dat, (now & NDOTM_SR_DAT_BIT) ? 1 : 0);
+  if ((was ^ now) & NDOTM_SR_CLK_BIT)
+    Record(host_trace_sr_clk, (now & NDOTM_SR_CLK_BIT) ? 1 : 0);
+  if ((was ^ now) & NDOTM_BLANK_DATOUT_BIT)
+    Record(host_trace_blank, (now & NDOTM_BLANK_DATOUT_BIT) ? 1 : 0);
+}
+
+static void TraceByte(uint8_t c) {
+  // a byte after an escape names a command. near enough: inside a raw or
+  // counted parameter it's just a value
+  Record(host_trace_byte, c);
+  if (after_escape && c != ndotm_cmd_escape_code)
+    Record(host_trace_command, c);
+  after_escape = (c == ndotm_cmd_escape_code) && !after_escape;
+  if (board_byte_hook)
+    board_byte_hook(c);
+}
+
+void HostTraceStart(void) {
+  if (!host_trace)
+    host_trace = (HostTraceEvent *)malloc(sizeof(HostTraceEvent) * HOST_TRACE_MAX);
+  host_trace_len = 0;
+  last_us = host_now_us;
+  same_us = 0;
+  after_escape = false;
+
+  board_pin_hook  = host_pin_hook;
+  board_port_hook = host_port_hook;
+  board_byte_hook = host_board_byte_hook;
+  host_pin_hook  = TracePin;
+  host_port_hook = TracePort;
+  host_board_byte_hook = TraceByte;
+}
+
+void HostTraceStop(void) {
+  // the board's clock runs ahead while it waits, so sort them out
+  host_pin_hook  = board_pin_hook;
+  host_port_hook = board_port_hook;
+  host_board_byte_hook = board_byte_hook;
+  std::stable_sort(host_trace, host_trace + host_trace_len,
+                   [](const HostTraceEvent &a, const HostTraceEvent &b) { return a.ns < b.ns; });
+}
+
+bool HostTraceWrite(const char *path) {
+  static const char *const vars[host_trace_signals] = {
+    "wire 1 a CLK_IN", "wire 1 b DAT_IN", "wire 1 c SR_CLK", "wire 1 d SR_DAT",
+    "wire 1 e BLANK_DATOUT", "wire 8 f byte", "string 1 g command",
+  };
+  FILE *f = fopen(path, "w");
+  uint64_t at = ~0ULL;
+  uint8_t i;
+
+  if (!f)
+    return false;
+  fprintf(f, "$timescale 1ns $end\n$scope module board $end\n");
+  for (i = 0; i < host_trace_signals; i++)
+    fprintf(f, "$var %s $end\n", vars[i]);
+  fprintf(f, "$upscope $end\n$enddefinitions $end\n");
+  fprintf(f, "#0\n$dumpvars\n0a\n0b\n0c\n0d\n0e\nb0 f\nsnone g\n$end\n");
+
+  for (uint32_t e = 0; e < host_trace_len; e++) {
+    const HostTraceEvent &ev = host_trace[e];
+
+    if (ev.ns != at) {
+      at = ev.ns;
+      fprintf(f, "#%llu\n", (unsigned long long)at);
+    }
+    if (ev.signal == host_trace_byte) {
+      fprintf(f, "b");
+      for (i = 0; i < 8; i++)
+        fputc((ev.value << i) & 0x80 ? '1' : '0', f);
+      fprintf(f, " f\n");
+    } else if (ev.signal == host_trace_command) {
+      fprintf(f, "s%s g\n", HostTraceCommandName(ev.value));
+    } else {
+      fprintf(f, "%u%c\n", ev.value, 'a' + ev.signal);
+    }
+  }
+  return fclose(f) == 0;
+}
@@ -0,0 +1,45 @@
+/*
+  A logic analyser on a HostBoard
+
+  HostTraceStart() wraps the hooks HostBoardStart() put in and records
+  every change on the link (CLK_IN, DAT_IN), the shift registers (SR_CLK,
+  SR_DAT) and the blanking pin, with each byte the board receives and the
+  command it starts. HostTraceWrite() saves the lot as a Value Change
+  Dump for GTKWave.
+
+  Times are in ns. The board's own code takes no simulated time, so the
+  changes it makes within one microsecond are laid out 1 ns apart, in
+  order. Read the gaps between them as order, not as AVR cycles.
+*/
+
+#ifndef HostTrace_h
+#define HostTrace_h
+#include <stdint.h>
+
+enum host_trace_signal {
+  host_trace_clk_in,
+  host_trace_dat_in,
+  host_trace_sr_clk,
+  host_trace_sr_dat,
+  host_trace_blank,
+  host_trace_byte,    // value is the byte
+  host_trace_command, // value is the ndotm_cmd_
+  host_trace_signals,
+};
+
+struct HostTraceEvent {
+  uint64_t ns;
+  uint8_t signal, value;
+};
+
+void HostTraceStart(void);
+void HostTraceStop(void);
+bool HostTraceWrite(const char *); // false if the file can't be written
+
+// what's been recorded so far, in time order once HostTraceStop() is called
+extern HostTraceEvent *host_trace;
+extern uint32_t host_trace_len;
+
+const char *HostTraceCommandName(uint8_t);
+
+#endif // HostTrace_h
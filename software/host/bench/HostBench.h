@@ -0,0 +1,96 @@
+/*
+  Timing for the host benchmarks
+
+  BENCH(name, ops) { body } runs body ops times and prints ns and
+  instructions per op. Instructions come from the perf counters, and
+  print as - where the kernel won't give them out (containers, VMs, 
+  perf_event_paranoid). Both are the host's, not the ATtiny85's: use them
+  to compare one version of the code with another, not for AVR cycles.
+
+  Give a run count on the command line to scale ops down, e.g. 1 for a 
+  quick smoke run.
+*/
+
+#ifndef HostBench_h
+#define HostBench_h
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+static long bench_scale = 1000; // in 1000ths
+
+static int BenchCounter(void) {
+  static int fd = -2;
+  struct perf_event_attr pe;
+
+  if (fd != -2)
+    return fd;
+  memset(&pe, 0, sizeof(pe));
+  pe.type = PERF_TYPE_HARDWARE;
+  pe.size = sizeof(pe);
+  pe.config = PERF_COUNT_HW_INSTRUCTIONS;
+  pe.disabled = 1;
+  pe.exclude_kernel = 1;
+  pe.exclude_hv = 1;
+  fd = syscall(__NR_perf_event_open, &pe, 0, -1, -1, 0);
+  return fd;
+}
+
+static inline uint64_t BenchNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+struct BenchRun {
+  const char *name;
+  long ops, i;
+  uint64_t t0;
+  int fd;
+
+  BenchRun(const char *n, long o) : name(n), i(0) {
+    ops = o * bench_scale / 1000;
+    if (ops < 1)
+      ops = 1;
+    fd = BenchCounter();
+    if (fd >= 0) {
+      ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    t0 = BenchNs();
+  }
+  ~BenchRun() {
+    uint64_t ns = BenchNs() - t0, insns = 0;
+
+    if (fd >= 0) {
+      ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(fd, &insns, sizeof(insns)) != sizeof(insns))
+        fd = -1;
+    }
+    if (fd >= 0)
+      printf("%-32s %10.1f ns/op %10.1f insns/op\n", name, (double)ns / ops, (double)insns / ops);
+    else
+      printf("%-32s %10.1f ns/op %10s insns/op\n", name, (double)ns / ops, "-");
+  }
+};
+
+#define BENCH(name, n) for (BenchRun bench_run(name, n); bench_run.i < bench_run.ops; bench_run.i++)
+
+static inline void BenchArgs(int argc, char **argv) {
+  // optional run count: 1 is a smoke run, 1000 the full one
+  if (argc > 1)
+    bench_scale = atol(argv[1]);
+}
+
+// keep the compiler from dropping what's measured
+static inline void BenchKeep(uint32_t x) {
+  asm volatile("" : : "r"(x) : "memory");
+}
+
+#endif // HostBench_h
@@ -0,0 +1,57 @@
+/*
+  Host timings for the driver's frame encoder: what WriteFrame() costs to
+  work out the bytes for a frame, and how many bytes it comes to, for a
+  few kinds of change. Bytes go into tx[] the way Poll() has them, so
+  nothing waits on the wire.
+*/
+
+#include "Arduino.h"
+#include "HostBench.h"
+#include "HostSim.h"
+#define private public // the encoder's buffer
+#include "NovaDotMatrixDriver.h"
+
+static NovaDotMatrixDriver d;
+
+static void Encode(const char *name, uint8_t frames[][NDM_NUMCOLS], uint8_t count) {
+  uint32_t bytes = 0, sent = 0;
+
+  d.ForgetFrame();
+  d.tx_to_buf = true;
+  BENCH(name, 2000000) {
+    d.tx_len = 0;
+    d.WriteFrame(frames[bench_run.i % count]);
+    bytes += d.tx_len;
+    sent++;
+  }
+  d.tx_to_buf = false;
+  printf("%-32s %10.2f bytes/frame\n", "", (double)bytes / sent);
+}
+
+int main(int argc, char **argv) {
+  static uint8_t same[2][NDM_NUMCOLS] = {{1, 2, 3, 4, 5}, {1, 2, 3, 4, 5}};
+  static uint8_t pixel[2][NDM_NUMCOLS] = {{1, 2, 3, 4, 5}, {1, 2, 0x43, 4, 5}};
+  static uint8_t column[2][NDM_NUMCOLS] = {{1, 2, 3, 4, 5}, {1, 2, 0x7f, 4, 5}};
+  static uint8_t shifted[NDM_NUMCOLS + 1][NDM_NUMCOLS];
+  static uint8_t noise[16][NDM_NUMCOLS];
+
+  BenchArgs(argc, argv);
+  HostReset();
+  d.clk_pin  = 10;
+  d.data_pin = 11;
+  d.Setup();
+
+  for (uint8_t f = 0; f <= NDM_NUMCOLS; f++)
+    for (uint8_t c = 0; c < NDM_NUMCOLS; c++)
+      shifted[f][c] = 0x11 * ((c + f) % (NDM_NUMCOLS + 1)) & 0x7f;
+  for (uint8_t f = 0; f < 16; f++)
+    for (uint8_t c = 0; c < NDM_NUMCOLS; c++)
+      noise[f][c] = random(0x80);
+
+  Encode("WriteFrame unchanged", same, 2);
+  Encode("WriteFrame one pixel", pixel, 2);
+  Encode("WriteFrame one column", column, 2);
+  Encode("WriteFrame scrolling", shifted, NDM_NUMCOLS + 1);
+  Encode("WriteFrame noise", noise, 16);
+  return 0;
+}
@@ -0,0 +1,144 @@
+/*
+  Host timings for the board's hot paths: the font lookup, writing a
+  column, WriteNextCol() in each mode, DispTwoSmallChars(), and the
+  parser on a few recorded streams. See HostBench.h for what the numbers
+  are worth.
+*/
+
+#include <initializer_list>
+#include "HostBench.h"
+#include "HostSim.h"
+#include "HostBoard.h"
+#define private public // to set up each mode directly
+#include "NovaDotMatrix.h"
+#include "NovaDotMatrixCommands.h"
+
+NovaDotMatrix novadotmatrix;
+ATtinyTimer attinytimer;
+static NovaDotMatrix &n = novadotmatrix;
+
+static void Tx(std::initializer_list<int> bytes) {
+  for (int c : bytes)
+    HostBoardRx(c);
+}
+
+static void Reset(void) {
+  Tx({0x27, ndotm_cmd_reset});
+  n.demo = false;
+}
+
+static void Font(void) {
+  uint32_t sum = 0;
+
+  n.cur_font = n.cur_font_5x7;
+  BENCH("GetFont 5x7", 2000000)
+    sum += n.GetFont(bench_run.i % 95, bench_run.i % 5);
+  n.cur_font = n.cur_font_3x5;
+  BENCH("GetFont 3x5", 2000000)
+    sum += n.GetFont(bench_run.i % 95, bench_run.i % 3);
+  n.cur_font = n.cur_font_5x7;
+  BENCH("GetFont latin-1", 2000000)
+    sum += n.GetFont(0xa0 - 32 + bench_run.i % 96, bench_run.i % 5);
+  BenchKeep(sum);
+}
+
+static void Columns(void) {
+  BENCH("WriteCol", 1000000)
+    n.WriteCol(bench_run.i % NDOTM_NUMCOLS, bench_run.i);
+}
+
+static void NextCol(const char *name) {
+  BENCH(name, 1000000)
+    n.WriteNextCol();
+}
+
+static void Modes(void) {
+  Reset();
+  Tx({0x27, ndotm_cmd_data, 1, 2, 3, 4, 5});
+  n.WriteNextCol();
+  NextCol("WriteNextCol ModeNorm");
+
+  Reset();
+  Tx({0x27, ndotm_cmd_message, 'H', 'e', 'l', 'l', 'o', 0});
+  n.WriteNextCol();
+  n.scrollstep = 3;
+  NextCol("WriteNextCol scroll left");
+
+  Reset();
+  Tx({0x27, ndotm_cmd_scroll_dir, ndotm_scroll_up, 0x27, ndotm_cmd_message, 'H', 'e', 'l', 'l', 'o', 0});
+  n.WriteNextCol();
+  n.scrollstep = 3;
+  NextCol("WriteNextCol scroll up");
+
+  Reset();
+  Tx({0x27, ndotm_cmd_data, 1, 2, 3, 4, 5});
+  n.DrawFrame();
+  Tx({0x27, ndotm_cmd_transition_fx, ndotm_fx_dissolve, 8, 0x27, ndotm_cmd_data, 6, 7, 8, 9, 10});
+  n.Loop();
+  n.fx_step = 3;
+  NextCol("WriteNextCol dissolve");
+  Reset();
+  Tx({0x27, ndotm_cmd_data, 1, 2, 3, 4, 5});
+  n.DrawFrame();
+  Tx({0x27, ndotm_cmd_transition_fx, ndotm_fx_push_up, 8, 0x27, ndotm_cmd_data, 6, 7, 8, 9, 10});
+  n.Loop();
+  n.fx_step = 3;
+  NextCol("WriteNextCol push up");
+
+  Reset();
+  Tx({0x27, ndotm_cmd_canvas, 16, 0});
+  for (uint8_t i = 0; i < 16; i++)
+    HostBoardRx(i * 37);
+  Tx({0x27, ndotm_cmd_view, 5, 3});
+  n.WriteNextCol();
+  NextCol("WriteNextCol canvas");
+
+  Reset();
+  Tx({0x27, ndotm_cmd_2ch, '4', '2'});
+  BENCH("DispTwoSmallChars", 1000000)
+    n.DispTwoSmallChars(bench_run.i & 1);
+}
+
+static void Stream(const char *name, const uint8_t *bytes, uint16_t len) {
+  // per byte, as the main loop hands them over
+  Reset();
+  BENCH(name, 2000000)
+    HostBoardRx(bytes[bench_run.i % len]);
+}
+
+static void Parser(void) {
+  static const uint8_t text[] = "The quick brown fox jumps over the lazy dog. ";
+  static const uint8_t message[] = {0x27, ndotm_cmd_message, 'S', 'a', 'l', 'e', ' ', 0xc3, 0xa9, 't', 0xe2, 0x82, 0xac, 0};
+  static const uint8_t frames[] = {0x27, ndotm_cmd_data, 1, 2, 3, 4, 5, 0x27, ndotm_cmd_col, 2, 0x55,
+                                   0x27, ndotm_cmd_pixels, ndotm_pix_toggle | 0x1f, 0x40};
+  static const uint8_t packet[] = {0x27, ndotm_cmd_packet, 10, ndotm_cmd_data, 0x27, 2, 3, 4, 5,
+                                   ndotm_cmd_pixels, ndotm_pix_set | 0x03, 0x41, ndotm_cmd_flip, 0};
+  static const uint8_t canvas[] = {0x27, ndotm_cmd_canvas, 16, 0, 1, 2, 3, 4, 5, 6, 7, 8, 0x27, 10, 11, 12, 13, 14, 15, 16,
+                                   0x27, ndotm_cmd_pan, 1, 0};
+  uint8_t p[sizeof(packet)];
+
+  // the packet's crc, over the length and body
+  memcpy(p, packet, sizeof(p));
+  p[sizeof(p) - 1] = ndotm_crc8(0, p[2]);
+  for (uint8_t i = 3; i < sizeof(p) - 1; i++)
+    p[sizeof(p) - 1] = ndotm_crc8(p[sizeof(p) - 1], p[i]);
+
+  Stream("ProcessInData text", text, sizeof(text) - 1);
+  Stream("ProcessInData message", message, sizeof(message));
+  Stream("ProcessInData frames", frames, sizeof(frames));
+  Stream("ProcessInData packet", p, sizeof(p));
+  Stream("ProcessInData canvas", canvas, sizeof(canvas));
+}
+
+int main(int argc, char **argv) {
+  BenchArgs(argc, argv);
+  HostReset();
+  HostBoardStart(10, 11, 12);
+  host_port_hook = 0; // nobody watching the port
+  printf("firmware %dx%d\n", NDOTM_NUMCOLS, NDOTM_NUMROWS);
+  Font();
+  Columns();
+  Modes();
+  Parser();
+  return 0;
+}
@@ -0,0 +1,48 @@
+/*
+  SliceCanvas() across a whole wall: wall frames/s at 100, 1,000 and
+  10,000 boards in a row. Built with NDM_SLICE_WORDS 0 and 1 in
+  CMakeLists.txt, to compare.
+*/
+
+#include "Arduino.h"
+#include "HostBench.h"
+#include "HostSim.h"
+#include "NovaDotMatrixDriver.h"
+
+int main(int argc, char **argv) {
+  static const uint32_t walls[] = {100, 1000, 10000};
+  NovaDotMatrixDriver d;
+  uint8_t *canvas, dat[NDM_NUMCOLS];
+  uint16_t stride;
+  uint32_t sum = 0;
+  long frames;
+  uint64_t t0, ns;
+
+  BenchArgs(argc, argv);
+  HostReset();
+  printf("SliceCanvas, NDM_SLICE_WORDS %d\n", NDM_SLICE_WORDS);
+  for (uint32_t boards : walls) {
+    // the wall plus room to scroll a board's width
+    stride = (boards * NDM_NUMCOLS + NDM_NUMCOLS + 7) / 8 + 1;
+    canvas = (uint8_t *)malloc(stride * NDM_NUMROWS);
+    for (uint32_t i = 0; i < stride * NDM_NUMROWS; i++)
+      canvas[i] = random(256);
+
+    frames = 20000000L / boards * bench_scale / 1000;
+    if (frames < 1)
+      frames = 1;
+    t0 = BenchNs();
+    for (long f = 0; f < frames; f++) {
+      for (uint32_t b = 0; b < boards; b++) {
+        d.SliceCanvas(canvas, stride, b * NDM_NUMCOLS + f % NDM_NUMCOLS, 0, dat);
+        sum += dat[0] ^ dat[NDM_NUMCOLS - 1];
+      }
+    }
+    ns = BenchNs() - t0;
+    printf("%6u boards %12.0f wall frames/s %8.1f ns a board\n", boards, frames * 1e9 / ns,
+           (double)ns / frames / boards);
+    free(canvas);
+  }
+  BenchKeep(sum);
+  return 0;
+}
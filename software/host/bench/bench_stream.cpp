@@ -0,0 +1,171 @@
+/*
+  Playing big command stream files (tools/NdmStreamFile.h)
+
+  Writes NDM_STREAM_VERSION_WIDE streams of 64MB, 512MB and 3GB to
+  /tmp (scaled down with the run count), then times Open(), Seek() to
+  anywhere and Play() an entry at a time, with the resident set size
+  after each. The commands are left as holes in the file, so writing
+  one is mostly the index. For the smaller ones, read() into memory
+  is there to compare.
+
+    bench_stream [runs]
+*/
+
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "HostBench.h"
+#include "NdmStreamFile.h"
+
+#define STREAM_ENTRY_BYTES 256   // commands per entry
+#define STREAM_ENTRY_MS    20
+#define STREAM_PANELS      64
+#define STREAM_READ_MAX    (512ULL << 20) // biggest to read() in as well
+
+static long Rss(void) {
+  // resident set size in KB
+  FILE *f = fopen("/proc/self/status", "r");
+  char line[128];
+  long kb = -1;
+
+  if (!f)
+    return -1;
+  while (fgets(line, sizeof(line), f)) {
+    if (!strncmp(line, "VmRSS:", 6))
+      kb = atol(line + 6);
+  }
+  fclose(f);
+  return kb;
+}
+
+static void PutLe(uint8_t *p, uint64_t v, uint8_t len) {
+  while (len--) {
+    *p++ = v & 0xff;
+    v >>= 8;
+  }
+}
+
+static bool Make(const char *path, uint64_t bytes, uint64_t &entries) {
+  // index written a chunk at a time, commands left as a hole
+  uint8_t buf[NDM_STREAM_WIDE_ENTRY_LEN * 4096];
+  uint64_t start, e, n;
+  int fd;
+
+  entries = bytes / (STREAM_ENTRY_BYTES + NDM_STREAM_WIDE_ENTRY_LEN);
+  start   = NDM_STREAM_WIDE_HEADER_LEN + entries * NDM_STREAM_WIDE_ENTRY_LEN;
+  if ((fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+    return false;
+
+  memcpy(buf, "NDS", 3);
+  buf[3] = NDM_STREAM_VERSION_WIDE;
+  PutLe(buf + 4, entries, 4);
+  PutLe(buf + 8, start + entries * STREAM_ENTRY_BYTES, 8);
+  if (write(fd, buf, NDM_STREAM_WIDE_HEADER_LEN) != NDM_STREAM_WIDE_HEADER_LEN)
+    return false;
+
+  for (e = 0; e < entries; e += n) {
+    n = entries - e < 4096 ? entries - e : 4096;
+    for (uint64_t i = 0; i < n; i++) {
+      uint8_t *p = buf + i * NDM_STREAM_WIDE_ENTRY_LEN;
+      PutLe(p, (e + i) / STREAM_PANELS * STREAM_ENTRY_MS, 4);
+      p[4] = (e + i) % STREAM_PANELS;
+      PutLe(p + 5, start + (e + i) * STREAM_ENTRY_BYTES, 8);
+    }
+    if (write(fd, buf, n * NDM_STREAM_WIDE_ENTRY_LEN) != (ssize_t)(n * NDM_STREAM_WIDE_ENTRY_LEN))
+      return false;
+  }
+  if (ftruncate(fd, start + entries * STREAM_ENTRY_BYTES))
+    return false;
+  close(fd);
+  return true;
+}
+
+static uint64_t played;
+
+static void Send(uint8_t panel, const uint8_t *p, uint64_t len, void *) {
+  // touch what a transmit backend would
+  played += len + panel + p[0] + p[len - 1];
+}
+
+static void Run(uint64_t bytes) {
+  char path[64], name[64], size[24];
+  uint64_t entries, t0;
+  uint32_t last_ms;
+  long rss0;
+  NdmStreamFile f;
+
+  if (bytes >= 1 << 20)
+    snprintf(size, sizeof(size), "%lluMB", (unsigned long long)(bytes >> 20));
+  else
+    snprintf(size, sizeof(size), "%lluKB", (unsigned long long)(bytes >> 10));
+  snprintf(path, sizeof(path), "/tmp/bench_stream_%d.nds", (int)getpid());
+  t0 = BenchNs();
+  if (!Make(path, bytes, entries)) {
+    printf("can't write %s\n", path);
+    unlink(path);
+    return;
+  }
+  printf("%s, %llu entries, written in %.0f ms\n", size,
+      (unsigned long long)entries, (BenchNs() - t0) / 1e6);
+
+  rss0 = Rss();
+  snprintf(name, sizeof(name), "open %s", size);
+  BENCH(name, 1000) {
+    f.Open(path);
+    BenchKeep(f.entries);
+  }
+  printf("  %-30s %10ld KB more resident\n", "after Open()", Rss() - rss0);
+
+  last_ms = f.Time(f.entries - 1);
+  srandom(1);
+  snprintf(name, sizeof(name), "seek %s", size);
+  BENCH(name, 100000)
+    f.Seek(random() % (last_ms + 1));
+  printf("  %-30s %10ld KB more resident\n", "after the seeks", Rss() - rss0);
+
+  // from the middle on, every panel's entry each STREAM_ENTRY_MS
+  {
+    uint32_t ms = last_ms / 2;
+    f.Seek(ms);
+    snprintf(name, sizeof(name), "play %d entries %s", STREAM_PANELS, size);
+    BENCH(name, 10000) {
+      if (!f.Play(ms, Send, 0)) {
+        f.Seek(0);
+        ms = 0;
+      }
+      ms += STREAM_ENTRY_MS;
+    }
+  }
+  BenchKeep(played);
+  printf("  %-30s %10ld KB more resident\n", "after playing", Rss() - rss0);
+  f.Close();
+
+  if (bytes <= STREAM_READ_MAX) {
+    // the way it was done: the whole thing in memory
+    std::vector<uint8_t> all;
+    int fd;
+
+    rss0 = Rss();
+    t0 = BenchNs();
+    if ((fd = open(path, O_RDONLY)) >= 0) {
+      uint64_t got = 0;
+      ssize_t n;
+      all.resize(bytes);
+      while (got < bytes && (n = read(fd, all.data() + got, bytes - got)) > 0)
+        got += n;
+      close(fd);
+    }
+    printf("  %-30s %10.1f ms %7ld KB more resident\n", "read() it all instead",
+        (BenchNs() - t0) / 1e6, Rss() - rss0);
+  }
+  unlink(path);
+}
+
+int main(int argc, char **argv) {
+  static const uint64_t sizes[] = { 64ULL << 20, 512ULL << 20, 3ULL << 30 };
+
+  BenchArgs(argc, argv);
+  for (uint8_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    Run(sizes[i] * bench_scale / 1000);
+  return 0;
+}
@@ -0,0 +1,138 @@
+/*
+  A wall of boards, for capacity planning
+
+  Every board gets its own NovaDotMatrix and its own driver. A picture
+  wider than the wall scrolls across it. For each board and each frame,
+  SliceCanvas() cuts the board's part out, WriteFrame() encodes it, and
+  the bytes go straight into that board's parser. The board's frame is
+  checked against what was sent.
+
+  The boards are shared out between threads, a batch at a time off a
+  common counter, so a slow batch doesn't hold the others up. The
+  firmware is built with NDOTM_INSTANCE_STORAGE as thread_local, so each
+  thread has its own ndotm_instance.
+
+    bench_wall [boards] [threads] [frames]
+
+  Prints host throughput, and what the wall would need on real wires:
+  bytes and link time per board per frame, from WireMicros().
+*/
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "HostBench.h"
+#include "HostSim.h"
+#define private public // the encoder's buffer and the board's frame
+#include "NovaDotMatrix.h"
+#include "NovaDotMatrixCommands.h"
+#include "NovaDotMatrixDriver.h"
+#undef private
+
+ATtinyTimer attinytimer;
+
+#define WALL_BATCH 64 // boards a thread takes at a time
+
+struct Board {
+  NovaDotMatrix board;
+  NovaDotMatrixDriver driver;
+};
+
+struct Totals {
+  uint64_t frames, bytes, wrong;
+};
+
+static std::vector<Board> boards;
+static std::vector<uint8_t> canvas;
+static uint16_t stride;
+static uint32_t frames;
+static std::atomic<uint32_t> next_board;
+
+static void Run(Board &b, uint16_t x, Totals &t) {
+  uint8_t dat[NDM_NUMCOLS];
+  bool ok;
+
+  ndotm_instance = &b.board;
+  for (uint32_t f = 0; f < frames; f++) {
+    b.driver.SliceCanvas(canvas.data(), stride, x + f, 0, dat);
+    b.driver.tx_len = 0;
+    b.driver.WriteFrame(dat);
+    for (uint8_t i = 0; i < b.driver.tx_len; i++) {
+      b.board.indata = b.driver.tx[i];
+      b.board.indata_available = true;
+      b.board.ProcessInData();
+    }
+    // ndotm_cmd_data order is the board's buf[] backwards
+    ok = true;
+    for (uint8_t c = 0; c < NDM_NUMCOLS; c++)
+      ok = ok && b.board.buf[NDOTM_LASTCOL - c] == dat[c];
+    t.frames++;
+    t.bytes += b.driver.tx_len;
+    t.wrong += !ok;
+  }
+}
+
+static void Worker(Totals *t) {
+  uint32_t first, i;
+
+  memset(t, 0, sizeof(*t));
+  while ((first = next_board.fetch_add(WALL_BATCH)) < boards.size()) {
+    for (i = first; i < first + WALL_BATCH && i < boards.size(); i++)
+      Run(boards[i], i * NDM_NUMCOLS, *t);
+  }
+}
+
+int main(int argc, char **argv) {
+  uint32_t count = argc > 1 ? atol(argv[1]) : 1000;
+  uint32_t threads = argc > 2 ? atol(argv[2]) : std::thread::hardware_concurrency();
+  std::vector<std::thread> pool;
+  std::vector<Totals> totals;
+  Totals all = {0, 0, 0};
+  uint64_t t0, ns;
+  uint32_t width;
+  double per_frame, wire_us;
+
+  frames = argc > 3 ? atol(argv[3]) : 200;
+  if (!threads)
+    threads = 1;
+
+  // something like text going by: runs of dots with gaps between
+  width  = count * NDM_NUMCOLS + frames + 8;
+  stride = (width + 7) / 8 + 1;
+  canvas.assign(stride * NDM_NUMROWS, 0);
+  for (uint32_t i = 0; i < canvas.size(); i++)
+    canvas[i] = (i % 7) ? random(256) & random(256) : 0;
+
+  // power up in turn. Setup() shares attinytimer and the pins
+  HostReset();
+  boards.resize(count);
+  for (Board &b : boards) {
+    b.board.Setup();
+    b.board.demo = false;
+    b.driver.Setup();
+    b.driver.tx_to_buf = true;
+  }
+
+  t0 = BenchNs();
+  totals.resize(threads);
+  for (uint32_t i = 0; i < threads; i++)
+    pool.push_back(std::thread(Worker, &totals[i]));
+  for (std::thread &th : pool)
+    th.join();
+  ns = BenchNs() - t0;
+
+  for (Totals &t : totals) {
+    all.frames += t.frames;
+    all.bytes  += t.bytes;
+    all.wrong  += t.wrong;
+  }
+  per_frame = (double)all.bytes / all.frames;
+  wire_us = per_frame * boards[0].driver.WireMicros(1);
+  printf("wall: %u boards, %u threads, %u frames\n", count, threads, frames);
+  printf("  host    %.0f board frames/s, %.1f ns a board frame\n",
+         all.frames * 1e9 / ns, (double)ns * threads / all.frames);
+  printf("  wire    %.2f bytes a board frame, %.1f ms of link, %.1f frames/s a board at most\n",
+         per_frame, wire_us / 1000, 1e6 / wire_us);
+  printf("  wrong   %llu\n", (unsigned long long)all.wrong);
+  return all.wrong || all.frames != (uint64_t)count * frames;
+}
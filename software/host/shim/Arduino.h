@@ -0,0 +1,54 @@
+/*
+  Arduino.h for building the libraries on a Linux host
+
+  Just enough of the Arduino core for NovaDotMatrix and NovaDotMatrixDriver.
+  Time is simulated and only moves when something waits, so runs are
+  repeatable. Pins 0 to 7 are the board's port B. Anything higher is a pin
+  on the host side, for the driver. Reading one takes a microsecond, so
+  a loop polling a pin sees time go by. See HostSim.h to watch or wire
+  them up.
+*/
+
+#ifndef HostArduino_h
+#define HostArduino_h
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define LOW          0
+#define HIGH         1
+#define INPUT        0
+#define OUTPUT       1
+#define INPUT_PULLUP 2
+#define LSBFIRST     0
+#define MSBFIRST     1
+
+#define HOST_BOARD_PINS 8 // pins below this are PB0.. on the board
+
+void pinMode(uint8_t, uint8_t);
+void digitalWrite(uint8_t, uint8_t);
+int digitalRead(uint8_t);
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long);
+void delayMicroseconds(unsigned int);
+
+long random(long);
+long random(long, long);
+void randomSeed(unsigned long);
+
+inline void noInterrupts(void) { cli(); }
+inline void interrupts(void)   { sei(); }
+
+// the ATtiny85 has the one port
+#define digitalPinToPort(p)  2
+#define portInputRegister(p) (&PINB)
+
+#endif // HostArduino_h
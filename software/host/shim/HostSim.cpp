@@ -0,0 +1,170 @@
+/*
+  Arduino core, AVR registers and EEPROM for host builds. See HostSim.h
+*/
+
+#include "Arduino.h"
+#include "SPI.h"
+#include "avr/eeprom.h"
+#include "HostSim.h"
+
+thread_local HostPort PORTB;
+thread_local volatile uint8_t PINB, DDRB;
+thread_local volatile uint8_t GIMSK, PCMSK;
+thread_local volatile uint8_t TIMSK, TCCR1, TCNT1, TCCR0B, TCNT0;
+thread_local volatile uint8_t USICR, USISR, USIBR, USIDR;
+thread_local volatile uint8_t SREG;
+
+uint8_t host_eeprom[HOST_EEPROM_LEN];
+uint32_t host_eeprom_writes;
+
+SPIClass SPI;
+
+uint64_t host_now_us;
+uint8_t host_pin[HOST_PINS];
+
+void (*host_pin_hook)(uint8_t, uint8_t);
+int  (*host_read_hook)(uint8_t);
+void (*host_port_hook)(uint8_t, uint8_t);
+void (*host_time_hook)(uint64_t);
+void (*host_spi_hook)(uint8_t);
+
+static unsigned long host_random_state = 1;
+static bool host_in_time_hook;
+
+void HostReset(void) {
+  PORTB.val = 0;
+  PINB = DDRB = 0;
+  GIMSK = PCMSK = 0;
+  TIMSK = TCCR1 = TCNT1 = TCCR0B = TCNT0 = 0;
+  USICR = USISR = USIBR = USIDR = 0;
+  SREG = 0;
+
+  memset(host_eeprom, 0xff, sizeof(host_eeprom)); // erased
+  host_eeprom_writes = 0;
+
+  host_now_us = 0;
+  memset(host_pin, 0, sizeof(host_pin));
+  host_pin_hook  = 0;
+  host_read_hook = 0;
+  host_port_hook = 0;
+  host_time_hook = 0;
+  host_spi_hook  = 0;
+  host_random_state = 1;
+}
+
+void HostAdvance(uint64_t us) {
+  // let the rest of the world catch up, but not from inside itself
+  uint64_t until = host_now_us + us;
+
+  if (host_time_hook && !host_in_time_hook) {
+    host_in_time_hook = true;
+    host_time_hook(until);
+    host_in_time_hook = false;
+  }
+  if (host_now_us < until)
+    host_now_us = until;
+}
+
+void HostPort::Set(uint8_t v) {
+  uint8_t was = val;
+
+  val = v;
+  if (v != was && host_port_hook)
+    host_port_hook(was, v);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin < HOST_BOARD_PINS) {
+    if (mode == OUTPUT)
+      DDRB |= _BV(pin);
+    else
+      DDRB &= ~_BV(pin);
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if (pin < HOST_BOARD_PINS) {
+    if (val)
+      PORTB |= _BV(pin);
+    else
+      PORTB &= ~_BV(pin);
+    return;
+  }
+  if (pin >= HOST_PINS)
+    return;
+  val = val ? HIGH : LOW;
+  if (host_pin[pin] == val)
+    return;
+  host_pin[pin] = val;
+  if (host_pin_hook)
+    host_pin_hook(pin, val);
+}
+
+int digitalRead(uint8_t pin) {
+  int v;
+
+  if (pin < HOST_BOARD_PINS)
+    return (PINB >> pin) & 1;
+  if (pin >= HOST_PINS)
+    return LOW;
+  HostAdvance(1); // so a loop polling a pin sees time go by
+  if (host_read_hook && (v = host_read_hook(pin)) >= 0)
+    return v;
+  return host_pin[pin];
+}
+
+unsigned long millis(void) {
+  return host_now_us / 1000;
+}
+
+unsigned long micros(void) {
+  return host_now_us;
+}
+
+void delay(unsigned long ms) {
+  HostAdvance(ms * 1000ULL);
+}
+
+void delayMicroseconds(unsigned int us) {
+  HostAdvance(us);
+}
+
+long random(long howbig) {
+  // same LCG as the C library's rand() example, so runs repeat
+  if (howbig <= 0)
+    return 0;
+  host_random_state = host_random_state * 1103515245UL + 12345;
+  return (host_random_state >> 16) % howbig;
+}
+
+long random(long howsmall, long howbig) {
+  if (howsmall >= howbig)
+    return howsmall;
+  return howsmall + random(howbig - howsmall);
+}
+
+void randomSeed(unsigned long seed) {
+  if (seed)
+    host_random_state = seed;
+}
+
+uint8_t eeprom_read_byte(const uint8_t *p) {
+  return host_eeprom[(uintptr_t)p % HOST_EEPROM_LEN];
+}
+
+void eeprom_write_byte(uint8_t *p, uint8_t v) {
+  host_eeprom[(uintptr_t)p % HOST_EEPROM_LEN] = v;
+  host_eeprom_writes++;
+  host_now_us += HOST_EEPROM_WRITE_US; // the chip waits on EEPE. the world catches up after
+}
+
+void eeprom_update_byte(uint8_t *p, uint8_t v) {
+  if (eeprom_read_byte(p) != v)
+    eeprom_write_byte(p, v);
+}
+
+uint8_t SPIClass::transfer(uint8_t val) {
+  if (host_spi_hook)
+    host_spi_hook(val);
+  return 0;
+}
@@ -0,0 +1,30 @@
+/*
+  The simulated world the host shim runs in
+
+  Time is host_now_us and only moves when code waits (delay(),
+  delayMicroseconds()) or a test calls HostAdvance(). While it moves,
+  host_time_hook gets the chance to run whatever else lives in the world,
+  usually a board on the other end of the driver's pins (see HostBoard.h).
+
+  The hooks are all optional, and HostReset() clears them.
+*/
+
+#ifndef HostSim_h
+#define HostSim_h
+#include <stdint.h>
+
+#define HOST_PINS 32
+
+extern uint64_t host_now_us;
+extern uint8_t host_pin[HOST_PINS]; // host side levels, as last written
+
+extern void (*host_pin_hook)(uint8_t, uint8_t);  // pin, level. a host pin was written
+extern int  (*host_read_hook)(uint8_t);          // pin. level of a host pin, -1 for host_pin[]
+extern void (*host_port_hook)(uint8_t, uint8_t); // was, now. the board's PORTB changed
+extern void (*host_time_hook)(uint64_t);         // run the world up to this time
+extern void (*host_spi_hook)(uint8_t);           // byte out of SPI
+
+void HostAdvance(uint64_t);
+void HostReset(void);
+
+#endif // HostSim_h
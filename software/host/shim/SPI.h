@@ -0,0 +1,32 @@
+/*
+  SPI for host builds. Bytes sent go to host_spi_hook, if set.
+*/
+
+#ifndef HostSPI_h
+#define HostSPI_h
+#include <stdint.h>
+
+#define SPI_MODE0 0
+#define SPI_MODE1 1
+#define SPI_MODE2 2
+#define SPI_MODE3 3
+
+struct SPISettings {
+  uint32_t hz;
+  uint8_t order, mode;
+  SPISettings(uint32_t h, uint8_t o, uint8_t m) : hz(h), order(o), mode(m) { }
+};
+
+class SPIClass {
+  public:
+    void begin(void) { }
+    void end(void) { }
+    void beginTransaction(SPISettings s) { hz = s.hz; }
+    void endTransaction(void) { }
+    uint8_t transfer(uint8_t);
+    uint32_t hz; // clock of the last transaction
+};
+
+extern SPIClass SPI;
+
+#endif // HostSPI_h
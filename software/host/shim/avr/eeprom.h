@@ -0,0 +1,24 @@
+/*
+  EEPROM for host builds
+
+  Addresses index host_eeprom[], which starts out erased (0xff) like a new
+  part. host_eeprom_writes counts the cells actually written, so a test can
+  tell an update that changed nothing from one that wore the part. Each
+  write holds the chip up for HOST_EEPROM_WRITE_US, as the real one does.
+*/
+
+#ifndef HostAvrEeprom_h
+#define HostAvrEeprom_h
+#include <stdint.h>
+
+#define HOST_EEPROM_LEN      512  // ATtiny85
+#define HOST_EEPROM_WRITE_US 3400 // erase and write, from the datasheet
+
+extern uint8_t host_eeprom[HOST_EEPROM_LEN];
+extern uint32_t host_eeprom_writes;
+
+uint8_t eeprom_read_byte(const uint8_t *);
+void eeprom_write_byte(uint8_t *, uint8_t);
+void eeprom_update_byte(uint8_t *, uint8_t);
+
+#endif // HostAvrEeprom_h
@@ -0,0 +1,22 @@
+/*
+  Interrupts for host builds
+
+  An ISR becomes a plain function of the vector's name, so a test or
+  HostBoard.cpp can call it when the pin or timer it stands for fires.
+  Nothing runs behind the code's back, so sei() and cli() have nothing to do.
+*/
+
+#ifndef HostAvrInterrupt_h
+#define HostAvrInterrupt_h
+#include <stdint.h>
+
+#define ISR(vector) extern "C" void vector(void); void vector(void)
+
+extern "C" void PCINT0_vect(void);
+extern "C" void USI_OVF_vect(void);
+extern "C" void TIMER1_OVF_vect(void);
+
+inline void sei(void) { }
+inline void cli(void) { }
+
+#endif // HostAvrInterrupt_h
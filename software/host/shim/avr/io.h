@@ -0,0 +1,57 @@
+/*
+  ATtiny85 registers for host builds
+
+  They are plain bytes, except PORTB, which tells HostSim.h about every
+  change so the shift register and blanking pins can be traced. Each 
+  thread has its own set, as if it were its own chip.
+*/
+
+#ifndef HostAvrIo_h
+#define HostAvrIo_h
+#include <stdint.h>
+
+struct HostPort {
+  uint8_t val;
+  void Set(uint8_t); // in HostSim.cpp
+  HostPort &operator=(uint8_t v)  { Set(v); return *this; }
+  HostPort &operator|=(uint8_t m) { Set(val | m); return *this; }
+  HostPort &operator&=(uint8_t m) { Set(val & m); return *this; }
+  HostPort &operator^=(uint8_t m) { Set(val ^ m); return *this; }
+  operator uint8_t() const { return val; }
+};
+
+extern thread_local HostPort PORTB;
+extern thread_local volatile uint8_t PINB, DDRB;
+extern thread_local volatile uint8_t GIMSK, PCMSK;
+extern thread_local volatile uint8_t TIMSK, TCCR1, TCNT1, TCCR0B, TCNT0;
+extern thread_local volatile uint8_t USICR, USISR, USIBR, USIDR;
+extern thread_local volatile uint8_t SREG;
+
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+
+#define _BV(b) (1 << (b))
+
+// TIMSK
+#define TOIE1 2
+
+// USICR
+#define USISIE 7
+#define USIOIE 6
+#define USIWM1 5
+#define USIWM0 4
+#define USICS1 3
+#define USICS0 2
+#define USICLK 1
+#define USITC  0
+
+// USISR
+#define USISIF 7
+#define USIOIF 6
+#define USIPF  5
+
+#endif // HostAvrIo_h
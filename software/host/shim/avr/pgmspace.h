@@ -0,0 +1,18 @@
+/*
+  Flash for host builds: it's all just memory
+*/
+
+#ifndef HostAvrPgmspace_h
+#define HostAvrPgmspace_h
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(p)  (*(const uint8_t *)(p))
+#define pgm_read_word(p)  (*(const uint16_t *)(p))
+#define pgm_read_dword(p) (*(const uint32_t *)(p))
+#define memcpy_P memcpy
+#define strlen_P strlen
+
+#endif // HostAvrPgmspace_h
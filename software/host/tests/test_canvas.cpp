@@ -0,0 +1,83 @@
+/*
+  The canvas: loading it through counted parameters and packets, the
+  view onto it, panning with wrap, and drift.
+*/
+
+#include <initializer_list>
+#include "HostTest.h"
+#include "HostSim.h"
+#include "HostBoard.h"
+#define private public // the tests look at the view
+#include "NovaDotMatrix.h"
+#include "NovaDotMatrixCommands.h"
+
+NovaDotMatrix novadotmatrix;
+ATtinyTimer attinytimer;
+static NovaDotMatrix &n = novadotmatrix;
+
+static void Tx(std::initializer_list<int> bytes) {
+  for (int c : bytes)
+    HostBoardRx(c);
+}
+
+static void Packet(std::initializer_list<int> body) {
+  uint8_t len = body.size(), crc = ndotm_crc8(0, len);
+
+  Tx({ndotm_cmd_escape_code, ndotm_cmd_packet, len});
+  for (int c : body) {
+    crc = ndotm_crc8(crc, c);
+    HostBoardRx(c);
+  }
+  HostBoardRx(crc);
+}
+
+static void Tick(void) {
+  // one scroll step, straight away
+  n.dwell_ctr = 0;
+  n.scroll_rate_ctr = 1;
+  n.ScrollAndDwellManage();
+}
+
+int main(void) {
+  uint8_t want[5] = {0x40, 0x27, 3, 2, 1}; // coldata runs right to left
+
+  HostReset();
+  HostBoardStart(10, 11, 12);
+
+  // counted bytes are raw, escape code and all
+  Tx({0x27, ndotm_cmd_reset, 0x27, ndotm_cmd_canvas, 3, 0, 0x27, 0x27, 0x27});
+  CHECK(n.indata_state == n.indata_state_norm && n.buf[2] == 0x27);
+
+  // loaded in pieces, inside packets, with commands after
+  Packet({ndotm_cmd_canvas, 8, 0, 1, 2, 3, 0x27, 0x40, 6});
+  CHECK(n.indata_state == n.indata_state_norm && n.canvas_ctr == 6);
+  Packet({ndotm_cmd_canvas, 8, 6, 7, 8, ndotm_cmd_rate, 1});
+  CHECK(n.indata_state == n.indata_state_norm && n.buf[7] == 8 && n.buf[3] == 0x27 && n.scroll_rate_div == 1);
+  for (uint8_t i = 0; i < 5; i++)
+    CHECK(n.CanvasCol(i) == want[i]);
+
+  // pans wrap round the canvas both ways
+  Tx({0x27, ndotm_cmd_pan, (uint8_t)-2, 0});
+  CHECK(n.view_x == 6 && n.CanvasCol(4) == 7 && n.CanvasCol(2) == 1 && n.CanvasCol(0) == 3);
+  Tx({0x27, ndotm_cmd_view, 3, 1});
+  CHECK(n.view_x == 3 && n.view_y == 1 && n.CanvasCol(4) == (0x4e & 0x7f) && n.CanvasCol(3) == 0x01);
+  Tx({0x27, ndotm_cmd_pan, 0, (uint8_t)-2});
+  CHECK(n.view_y == 6 && n.CanvasCol(3) == 0x20);
+
+  // drift moves the view a step each scroll tick, and the display follows
+  Tx({0x27, ndotm_cmd_drift, 1, 0});
+  n.Mode = n.ModeNorm;
+  Tick();
+  CHECK(n.view_x == 4);
+  for (uint8_t i = 0; i < 8 * 5; i++) {
+    n.Mode = n.ModeNorm;
+    n.WriteNextCol();
+  }
+  CHECK(n.coldata[4] == n.CanvasCol(4));
+
+  // anything else on the display and pans do nothing
+  Tx({0x27, ndotm_cmd_data, 1, 2, 3, 4, 5, 0x27, ndotm_cmd_pan, 1, 0});
+  CHECK(n.view_x == 4);
+
+  return HostTestDone("canvas");
+}
@@ -0,0 +1,149 @@
+/*
+  What the board keeps in eeprom: playlist slots, messages cut to
+  NDOTM_MSGLEN, how long a master has to wait while a slot is written,
+  and glyphs, drawn or never drawn.
+*/
+
+#include <initializer_list>
+#include <avr/eeprom.h>
+#include "HostTest.h"
+#include "HostSim.h"
+#include "HostBoard.h"
+#define private public // the playlist's state
+#include "NovaDotMatrix.h"
+#undef private
+#include "NovaDotMatrixCommands.h"
+#include "NovaDotMatrixDriver.h"
+
+NovaDotMatrix novadotmatrix;
+ATtinyTimer attinytimer;
+static NovaDotMatrix &n = novadotmatrix;
+
+#define SLOT(s) (host_eeprom + NDOTM_PLAYLIST_EEPROM + (s) * NDOTM_PLAYLIST_SLOT_LEN)
+
+static void Tx(std::initializer_list<int> bytes) {
+  for (int c : bytes)
+    HostBoardRx(c);
+}
+
+static void Playlist(void) {
+  uint8_t *e;
+
+  HostReset();
+  HostBoardStart(10, 11, 12);
+
+  // raw parameters, so the rate can be the escape code
+  Tx({0x27, ndotm_cmd_playlist_store, 0, 5, 0x27, ndotm_playlist_3x5, 'A', 'B', 0});
+  e = SLOT(0);
+  CHECK(e[0] == 5 && e[1] == 0x27 && e[2] == ndotm_playlist_3x5);
+  CHECK(e[3] == 'A' && e[4] == 'B' && e[5] == 0);
+  CHECK(n.Mode == n.ModeStartScrollMessage && n.buf[0] == 'A');
+
+  // too long: cut to NDOTM_MSGLEN, the rest never shows, the next slot untouched
+  Tx({0x27, ndotm_cmd_playlist_store, 1, 9, 3, ndotm_playlist_flip});
+  for (uint8_t i = 0; i < NDOTM_MSGLEN + 8; i++)
+    HostBoardRx('a' + i % 26);
+  HostBoardRx(0);
+  e = SLOT(1);
+  CHECK(e[3] == 'a' && e[3 + NDOTM_MSGLEN - 1] == 'a' + (NDOTM_MSGLEN - 1) % 26 && e[3 + NDOTM_MSGLEN] == 0);
+  CHECK(SLOT(2)[0] == 0xff);
+  CHECK(n.buf[NDOTM_MSGLEN] == 0 && n.indata_state == n.indata_state_norm && n.buf[0] == 'a');
+
+  // storing it again changes nothing, so nothing is written
+  uint32_t writes = host_eeprom_writes;
+  Tx({0x27, ndotm_cmd_playlist_store, 0, 5, 0x27, ndotm_playlist_3x5, 'A', 'B', 0});
+  CHECK(host_eeprom_writes == writes);
+
+  // round the slots
+  Tx({0x27, ndotm_cmd_playlist, 0, 3});
+  CHECK(n.playlist_count == 3 && n.buf[0] == 'A' && n.buf[2] == 0);
+  CHECK(n.dwell_div == 5 && n.cur_font == n.cur_font_3x5);
+  n.PlaylistNext();
+  CHECK(n.buf[0] == 'a' && n.dwell_div == 9 && n.pin_end_is_top && n.cur_font == n.cur_font_5x7);
+  n.PlaylistNext(); // slot 2 is empty
+  CHECK(n.buf[0] == 'A');
+  Tx({0x27, ndotm_cmd_message, 'x', 0});
+  CHECK(n.playlist_count == 0);
+  Tx({0x27, ndotm_cmd_playlist, NDOTM_PLAYLIST_SLOTS, 1});
+  CHECK(n.playlist_count == 0);
+}
+
+static void StoreTime(void) {
+  // over the wire, the board is deaf while it writes. after
+  // NDOTM_PLAYLIST_STORE_MS it isn't
+  NovaDotMatrixDriver d;
+  uint8_t cmd[6 + NDOTM_MSGLEN + 1];
+  uint8_t i;
+
+  for (uint8_t wait = 0; wait < 2; wait++) {
+    HostReset();
+    HostBoardStart(10, 11, 12);
+    memset(&d, 0, sizeof(d));
+    d.clk_pin  = 10;
+    d.data_pin = 11;
+    d.Setup();
+
+    // the longest there is, on a blank part, so every byte is written
+    cmd[0] = 0x27;
+    cmd[1] = ndotm_cmd_playlist_store;
+    cmd[2] = 3;
+    cmd[3] = 1;
+    cmd[4] = 1;
+    cmd[5] = 0;
+    for (i = 0; i < NDOTM_MSGLEN; i++)
+      cmd[6 + i] = 'A' + i % 26;
+    cmd[6 + NDOTM_MSGLEN] = 0;
+    d.WriteBuf(cmd, sizeof(cmd));
+
+    if (wait)
+      delay(NDOTM_PLAYLIST_STORE_MS);
+    d.Write('Y');
+    d.Write('Z');
+    delay(NDOTM_PLAYLIST_STORE_MS);
+
+    CHECK(SLOT(3)[3 + NDOTM_MSGLEN] == 0 && SLOT(3)[3 + NDOTM_MSGLEN - 1] == cmd[6 + NDOTM_MSGLEN - 1]);
+    if (wait)
+      CHECK(!host_board_lost && n.buf[0] == 'Z');
+    else
+      CHECK(host_board_lost && n.buf[0] != 'Z');
+  }
+}
+
+static void Glyphs(void) {
+  uint8_t g = NDOTM_GLYPH_FIRST + 1;
+
+  HostReset();
+  HostBoardStart(10, 11, 12);
+
+  // a new part: blank in both fonts, not a solid block
+  for (uint8_t i = 0; i < NDOTM_GLYPH_LEN; i++)
+    CHECK(n.GetFont(g - 32, i) == 0);
+  n.cur_font = n.cur_font_3x5;
+  CHECK(n.GetFont(g - 32, 0) == 0);
+  n.cur_font = n.cur_font_5x7;
+
+  // raw parameters, so a column can be the escape code
+  Tx({0x27, ndotm_cmd_glyph, g, 1, 2, 0x27, 0x7f, 5});
+  CHECK(n.GetFont(g - 32, 0) == 1 && n.GetFont(g - 32, 2) == 0x27 && n.GetFont(g - 32, 4) == 5);
+  CHECK(n.GetFont(g - 32 + 1, 0) == 0); // the next one is still blank
+  Tx({0x27, ndotm_cmd_glyph, NDOTM_GLYPH_FIRST + NDOTM_GLYPHS, 9, 9, 9, 9, 9}); // not one of ours
+  CHECK(host_eeprom[NDOTM_GLYPH_EEPROM + NDOTM_GLYPHS * NDOTM_GLYPH_LEN] == 0xff);
+
+  // one column of 0xff is drawn, if the rest aren't
+  Tx({0x27, ndotm_cmd_glyph, g, 0xff, 0, 0, 0, 0});
+  CHECK(n.GetFont(g - 32, 0) == 0xff);
+  Tx({0x27, ndotm_cmd_glyph, g, 0xff, 0xff, 0xff, 0xff, 0xff});
+  CHECK(n.GetFont(g - 32, 0) == 0);
+
+  // and in a message
+  Tx({0x27, ndotm_cmd_glyph, g, 0x41, 0x22, 0x14, 0x08, 0x7f});
+  Tx({0x27, ndotm_cmd_message, 'a', g, 0});
+  CHECK(n.buf[1] == g && n.GetFont(n.buf[1] - 32, 4) == 0x7f);
+}
+
+int main(void) {
+  Playlist();
+  StoreTime();
+  Glyphs();
+  return HostTestDone("eeprom");
+}
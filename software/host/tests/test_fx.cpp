@@ -0,0 +1,109 @@
+/*
+  Transition effects go the way they say, both ways up: text the way it
+  scrolls, turned with the panel when it's flipped, and data the way it
+  was sent, whatever pin_end_is_top says.
+*/
+
+#include <initializer_list>
+#include "HostTest.h"
+#include "HostSim.h"
+#include "HostBoard.h"
+#define private public // the tests look at the frames
+#include "NovaDotMatrix.h"
+#include "NovaDotMatrixCommands.h"
+#include "TransitionMasks.h"
+
+NovaDotMatrix novadotmatrix;
+ATtinyTimer attinytimer;
+static NovaDotMatrix &n = novadotmatrix;
+
+static void Tx(std::initializer_list<int> bytes) {
+  for (int c : bytes)
+    HostBoardRx(c);
+}
+
+static uint8_t Seen(const uint8_t *cols, uint8_t i, bool turned) {
+  //
+  // column i from the left as someone looking at the panel sees it, top
+  // row in bit 0. WriteCol() puts coldata[c] out at column
+  // NDOTM_LASTCOL - c and bit 0 on the bottom row when pin_end_is_top
+  // (test_geometry). turned, they're standing on their head with it
+  //
+  uint8_t p = turned ? NDOTM_LASTCOL - i : i, c, v = 0;
+
+  c = cols[n.pin_end_is_top ? NDOTM_LASTCOL - p : p];
+  if (n.pin_end_is_top == turned)
+    return c;
+  for (uint8_t b = 0; b < NDOTM_NUMROWS; b++)
+    if (c & (1 << b))
+      v |= 1 << (NDOTM_NUMROWS - 1 - b);
+  return v;
+}
+
+static void Halfway(void) {
+  // the middle of the effect, however fast it's going
+  n.fx_step = NDOTM_FX_STEPS / 2;
+  for (uint8_t i = 0; i < NDOTM_NUMCOLS; i++)
+    n.FxDraw(i);
+}
+
+static void Push(bool text, bool flip) {
+  uint8_t old[NDOTM_NUMCOLS], now[NDOTM_NUMCOLS], k, v;
+  bool turned = text && flip; // a flipped panel is mounted upside down
+  uint8_t fx;
+
+  for (fx = ndotm_fx_push_left; fx <= ndotm_fx_push_up; fx += ndotm_fx_push_up - ndotm_fx_push_left) {
+    HostReset();
+    HostBoardStart(10, 11, 12);
+    Tx({0x27, ndotm_cmd_reset});
+    Tx({0x27, flip ? ndotm_cmd_flip : ndotm_cmd_noflip});
+
+    // the old frame, all drawn. then the new one, left part way
+    if (text)
+      Tx({0x27, ndotm_cmd_char, 'L'});
+    else
+      Tx({0x27, ndotm_cmd_data, 0x01, 0x03, 0x07, 0x0f, 0x1f});
+    Tx({0x27, ndotm_cmd_transition_fx, fx, 255});
+    HostAdvance(20000);
+    if (text) {
+      Tx({0x27, ndotm_cmd_char, 'F'});
+    } else {
+      Tx({0x27, ndotm_cmd_data, 0x40, 0x60, 0x70, 0x78, 0x41});
+      if (!flip)
+        n.pin_end_is_top = false; // as after ndotm_cmd_noflip
+    }
+    HostAdvance(1000);
+    CHECK(n.Mode == n.ModeInTransition);
+
+    for (uint8_t i = 0; i < NDOTM_NUMCOLS; i++) {
+      old[i] = Seen(n.fx_old, i, turned);
+      now[i] = Seen(n.fx_new, i, turned);
+    }
+    CHECK(memcmp(old, now, NDOTM_NUMCOLS));
+    Halfway();
+
+    if (fx == ndotm_fx_push_left) {
+      // the old frame off to the left, the new one in from the right
+      k = (NDOTM_FX_STEPS / 2 * NDOTM_NUMCOLS) >> 3;
+      for (uint8_t i = 0; i < NDOTM_NUMCOLS; i++) {
+        v = (i + k < NDOTM_NUMCOLS) ? old[i + k] : now[i + k - NDOTM_NUMCOLS];
+        CHECK(Seen(n.coldata, i, turned) == v);
+      }
+    } else {
+      // the old frame off the top, the new one up from the bottom
+      k = (NDOTM_FX_STEPS / 2 * NDOTM_NUMROWS) >> 3;
+      for (uint8_t i = 0; i < NDOTM_NUMCOLS; i++) {
+        v = ((old[i] | (now[i] << NDOTM_NUMROWS)) >> k) & NDOTM_ALLROWS;
+        CHECK(Seen(n.coldata, i, turned) == v);
+      }
+    }
+  }
+}
+
+int main(void) {
+  for (uint8_t flip = 0; flip < 2; flip++) {
+    Push(true, flip);
+    Push(false, flip);
+  }
+  return HostTestDone("fx");
+}
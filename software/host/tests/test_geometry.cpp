@@ -0,0 +1,133 @@
+/*
+  Panel geometry: which shift register bits WriteCol() sets for each
+  column, both ways up, the wrap macros, and wider panels keeping text
+  and pixel ops to the first NDOTM_PIX_COLS columns. Built once for
+  each panel size in CMakeLists.txt.
+*/
+
+#include <initializer_list>
+#include "HostTest.h"
+#include "HostSim.h"
+#include "HostBoard.h"
+#define private public // the tests look at the frame buffers
+#include "NovaDotMatrix.h"
+#include "NovaDotMatrixCommands.h"
+
+NovaDotMatrix novadotmatrix;
+ATtinyTimer attinytimer;
+static NovaDotMatrix &n = novadotmatrix;
+
+#define SR_BITS (NDOTM_NUMCOLS + NDOTM_SR_GAP + NDOTM_NUMROWS)
+
+static uint8_t sr_bit[64];
+static uint8_t sr_bits;
+
+static void ShiftRegister(uint8_t was, uint8_t now) {
+  // data is clocked in on the rising edge
+  if (!(was & NDOTM_SR_CLK_BIT) && (now & NDOTM_SR_CLK_BIT) && sr_bits < sizeof(sr_bit))
+    sr_bit[sr_bits++] = (now & NDOTM_SR_DAT_BIT) ? 1 : 0;
+}
+
+static void Tx(std::initializer_list<int> bytes) {
+  for (int c : bytes)
+    HostBoardRx(c);
+}
+
+static void TxCols(uint8_t c) {
+  Tx({0x27, ndotm_cmd_data});
+  for (uint8_t i = 0; i < NDOTM_NUMCOLS; i++)
+    HostBoardRx(c);
+}
+
+static void Columns(void) {
+  // the last bit out sits at the start of the chain: rows, the gap, then
+  // the columns. everything is active low
+  uint8_t sr[64], rows;
+
+  host_port_hook = ShiftRegister;
+  for (uint8_t flip = 0; flip < 2; flip++) {
+    for (uint8_t col = 0; col < NDOTM_NUMCOLS; col++) {
+      n.pin_end_is_top = flip;
+      rows = (0xa5 ^ col) & NDOTM_ALLROWS;
+      sr_bits = 0;
+      n.WriteCol(col, rows);
+      CHECK(sr_bits == SR_BITS);
+      for (uint8_t k = 0; k < sr_bits; k++)
+        sr[sr_bits - 1 - k] = sr_bit[k];
+      for (uint8_t c = 0; c < NDOTM_NUMCOLS; c++)
+        CHECK(sr[8 + c] == (c == (flip ? NDOTM_LASTCOL - col : col) ? 0 : 1));
+      for (uint8_t b = 0; b < NDOTM_NUMROWS; b++)
+        CHECK(sr[flip ? b : NDOTM_NUMROWS - 1 - b] == ((rows >> b) & 1 ? 0 : 1));
+    }
+  }
+  host_port_hook = 0;
+}
+
+static void Wrap(void) {
+  uint8_t b[NDOTM_NUMCOLS];
+
+  for (uint8_t i = 0; i < NDOTM_NUMCOLS; i++)
+    b[i] = i + 1;
+  SHIFT_LEFT_WRAP(b);
+  CHECK(b[0] == 2 && b[NDOTM_LASTCOL] == 1);
+  SHIFT_RIGHT_WRAP(b);
+  SHIFT_RIGHT_WRAP(b);
+  CHECK(b[0] == NDOTM_NUMCOLS && b[1] == 1);
+  b[0] = NDOTM_TOPROW_BIT | 1;
+  SHIFT_UP_WRAP(b);
+  CHECK(b[0] == 3);
+  SHIFT_DOWN_WRAP(b);
+  CHECK(b[0] == (NDOTM_TOPROW_BIT | 1));
+}
+
+static void Frames(void) {
+  // ndotm_cmd_data fills the whole width, last column first
+  Tx({0x27, ndotm_cmd_data});
+  for (uint8_t i = 0; i < NDOTM_NUMCOLS; i++)
+    HostBoardRx(0x10 + i);
+  CHECK(n.buf[NDOTM_LASTCOL] == 0x10 && n.buf[0] == 0x10 + NDOTM_LASTCOL);
+  Tx({0x27, ndotm_cmd_data_scroll, 0x55});
+  CHECK(n.buf[0] == 0x55 && n.buf[NDOTM_LASTCOL] == 0x11);
+
+  // pixels only reach the first NDOTM_PIX_COLS columns, whatever the op
+  for (uint8_t op : {ndotm_pix_set, ndotm_pix_clear, ndotm_pix_toggle}) {
+    TxCols(0x2a);
+    Tx({0x27, ndotm_cmd_pixels, op | 0b00001, 0x01});
+    for (uint8_t k = 1; k < NDOTM_NUMCOLS; k++)
+      CHECK(n.buf[NDOTM_LASTCOL - k] == 0x2a);
+    CHECK(n.buf[NDOTM_LASTCOL] == (op == ndotm_pix_clear ? 0x2a : 0x2b));
+  }
+
+  // text leaves the columns past the font dark
+  TxCols(0x55);
+  n.txt_curp = (char *)n.buf;
+  n.DrawFrame();
+  Tx({0x27, ndotm_cmd_transition, 0, 'H'});
+  n.Mode = n.ModeNorm;
+  n.txt_curp = (char *)n.buf;
+  n.DrawFrame();
+  CHECK(n.coldata[0] == n.GetFont('H' - 32, 0));
+  for (uint8_t i = 5; i < NDOTM_NUMCOLS; i++)
+    CHECK(n.coldata[i] == 0);
+
+  // and so does small text
+  for (uint8_t i = 0; i < NDOTM_NUMCOLS; i++)
+    n.coldata[i] = 0x55;
+  Tx({0x27, ndotm_cmd_2ch, '1', '2'});
+  n.DrawFrame();
+  for (uint8_t i = 5; i < NDOTM_NUMCOLS; i++)
+    CHECK(n.coldata[i] == 0);
+}
+
+int main(void) {
+  char name[32];
+
+  HostReset();
+  HostBoardStart(10, 11, 12);
+  Tx({0x27, ndotm_cmd_reset});
+  Columns();
+  Wrap();
+  Frames();
+  snprintf(name, sizeof(name), "geometry %dx%d", NDOTM_NUMCOLS, NDOTM_NUMROWS);
+  return HostTestDone(name);
+}
@@ -0,0 +1,131 @@
+/*
+  The link on a logic analyser: the driver's Write() into a board, with
+  the clock and data edges checked against NDM_HALF_BIT_PERIOD_US and
+  NDM_INTERCMD_DELAY_MS, and the shift register loads kept inside the
+  blanking pulse. Give a file name to keep the trace as a VCD.
+*/
+
+#include "HostTest.h"
+#include "HostSim.h"
+#include "HostBoard.h"
+#include "HostTrace.h"
+#include "NovaDotMatrix.h"
+#include "NovaDotMatrixCommands.h"
+#include "NovaDotMatrixDriver.h"
+
+NovaDotMatrix novadotmatrix;
+ATtinyTimer attinytimer;
+
+// the trace is in ns, but only whole us are simulated time. see HostTrace.h
+#define US(ns) ((ns) / 1000)
+
+int main(int argc, char **argv) {
+  NovaDotMatrixDriver d;
+  uint8_t frame[NDM_NUMCOLS] = {0x7f, 0x41, 0x41, 0x41, 0x7f};
+  uint8_t body[] = {ndotm_cmd_dwell, 9, ndotm_cmd_col, 2, 0x27};
+  uint8_t sent[64], sent_len = 0, got[64], got_len = 0;
+  uint64_t rise = 0, fall = 0, byte_end = 0;
+  uint64_t min_high = ~0ULL, min_low = ~0ULL, min_gap = ~0ULL, min_hold = ~0ULL;
+  uint32_t bits = 0, blanks = 0, sr_clocks = 0, commands = 0, stray_sr = 0;
+  bool clk = false, blank = false;
+
+  HostReset();
+  HostBoardStart(10, 11, 12);
+  memset(&d, 0, sizeof(d));
+  d.clk_pin  = 10;
+  d.data_pin = 11;
+  d.Setup();
+
+  HostTraceStart();
+  d.Write(ndotm_cmd_escape_code);
+  d.Write(ndotm_cmd_reset);
+  d.WriteFrame(frame);
+  d.WritePacket(body, sizeof(body));
+  delay(20);
+  HostTraceStop();
+  CHECK(host_trace_len > 0 && !host_board_lost);
+
+  for (uint32_t e = 0; e < host_trace_len; e++) {
+    const HostTraceEvent &ev = host_trace[e];
+
+    switch (ev.signal) {
+      case host_trace_clk_in:
+        if (ev.value) {
+          // a new byte after a gap, or the next bit
+          if (bits % 8 == 0 && byte_end && US(ev.ns) - US(byte_end) < min_gap)
+            min_gap = US(ev.ns) - US(byte_end);
+          if (bits % 8 && US(ev.ns) - US(fall) < min_low)
+            min_low = US(ev.ns) - US(fall);
+          rise = ev.ns;
+          bits++;
+        } else {
+          if (US(ev.ns) - US(rise) < min_high)
+            min_high = US(ev.ns) - US(rise);
+          fall = ev.ns;
+          if (bits % 8 == 0)
+            byte_end = fall;
+        }
+        clk = ev.value;
+        break;
+
+      case host_trace_dat_in:
+        // never while the clock is high, and held from the rising edge
+        CHECK(!clk);
+        if (rise && US(ev.ns) - US(rise) < min_hold)
+          min_hold = US(ev.ns) - US(rise);
+        break;
+
+      case host_trace_sr_clk:
+        if (ev.value) {
+          sr_clocks++;
+          if (!blank)
+            stray_sr++;
+        }
+        break;
+
+      case host_trace_blank:
+        if (ev.value)
+          blanks++;
+        blank = ev.value;
+        break;
+
+      case host_trace_byte:
+        if (got_len < sizeof(got))
+          got[got_len++] = ev.value;
+        break;
+
+      case host_trace_command:
+        commands++;
+        break;
+    }
+  }
+
+  // what went out is what arrived
+  sent[sent_len++] = ndotm_cmd_escape_code;
+  sent[sent_len++] = ndotm_cmd_reset;
+  sent[sent_len++] = ndotm_cmd_escape_code;
+  sent[sent_len++] = ndotm_cmd_data;
+  for (uint8_t i = 0; i < NDM_NUMCOLS; i++)
+    sent[sent_len++] = frame[i];
+  CHECK(got_len > sent_len && !memcmp(got, sent, sent_len));
+  CHECK(bits == got_len * 8u);
+  CHECK(commands >= 3); // reset, data, packet
+
+  CHECK(min_high >= NDM_HALF_BIT_PERIOD_US);
+  CHECK(min_low >= NDM_HALF_BIT_PERIOD_US);
+  CHECK(min_hold >= NDM_HALF_BIT_PERIOD_US);
+  CHECK(min_gap >= NDM_INTERCMD_DELAY_MS * 1000UL);
+
+  // the shift registers only load with the display dark
+  CHECK(blanks > 0 && sr_clocks > 0 && !stray_sr);
+
+  printf("link: %u bytes, clock high %llu us, low %llu us, data held %llu us, gap %llu us\n",
+         got_len, (unsigned long long)min_high, (unsigned long long)min_low,
+         (unsigned long long)min_hold, (unsigned long long)min_gap);
+  printf("refresh: %u column loads, %u shift register clocks each, all with the display dark\n",
+         blanks, blanks ? sr_clocks / blanks : 0);
+
+  if (argc > 1)
+    CHECK(HostTraceWrite(argv[1]));
+  return HostTestDone("link");
+}
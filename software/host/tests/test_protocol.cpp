@@ -0,0 +1,151 @@
+/*
+  Host protocol: escapes, the command table's parameter flags, packets
+  and their crc, and giving up on a master that goes quiet.
+*/
+
+#include <initializer_list>
+#include "HostTest.h"
+#include "HostSim.h"
+#include "HostBoard.h"
+#define private public // the tests look at the parser's state
+#include "NovaDotMatrix.h"
+#include "NovaDotMatrixCommands.h"
+
+NovaDotMatrix novadotmatrix;
+ATtinyTimer attinytimer;
+static NovaDotMatrix &n = novadotmatrix;
+
+static void Tx(std::initializer_list<int> bytes) {
+  for (int c : bytes)
+    HostBoardRx(c);
+}
+
+static void Packet(std::initializer_list<int> body, int corrupt = -1) {
+  // <esc> ndotm_cmd_packet <len> <body> <crc>, with one body byte spoiled
+  uint8_t len = body.size(), crc = ndotm_crc8(0, len);
+  int i = 0;
+
+  Tx({ndotm_cmd_escape_code, ndotm_cmd_packet, len});
+  for (int c : body) {
+    crc = ndotm_crc8(crc, c);
+    HostBoardRx(i++ == corrupt ? c ^ 1 : c);
+  }
+  HostBoardRx(crc);
+}
+
+static void Quiet(uint16_t ticks) {
+  for (uint16_t i = 0; i < ticks; i++)
+    n.IdleManage();
+}
+
+int main(void) {
+  HostReset();
+  HostBoardStart(10, 11, 12);
+  Tx({0x27, ndotm_cmd_reset});
+
+  // plain bytes are characters
+  Tx({'B'});
+  CHECK(n.buf[0] == 'B' && n.buf_contents == NDOTM_BUF_CONTENTS_ASCII);
+
+  // fixed count. ndotm_cmd_data comes last column first
+  Tx({0x27, ndotm_cmd_data, 1, 2, 3, 4, 5});
+  CHECK(n.buf[4] == 1 && n.buf[0] == 5 && n.indata_state == n.indata_state_norm);
+
+  // an escape inside plain parameters starts a new command
+  Tx({0x27, ndotm_cmd_data, 9, 9, 0x27, ndotm_cmd_dwell, 7});
+  CHECK(n.dwell_div == 7 && n.buf[4] == 1);
+
+  // NDOTM_CMD_RAW: the escape code is just a value
+  Tx({0x27, ndotm_cmd_char, 0x27});
+  CHECK(n.buf[0] == 0x27 && n.indata_state == n.indata_state_norm);
+  Tx({0x27, ndotm_cmd_counter, ndotm_counter_wrap, 0x27});
+  CHECK(n.counter_val == 39);
+
+  // NDOTM_CMD_COUNTED: count in the high nibble of the first parameter
+  Tx({0x27, ndotm_cmd_data, 0, 0, 0, 0, 0});
+  Tx({0x27, ndotm_cmd_cols, 0x31, 7, 8, 9});
+  CHECK(n.buf[3] == 7 && n.buf[2] == 8 && n.buf[1] == 9 && n.buf[0] == 0 && n.buf[4] == 0);
+  Tx({0x27, ndotm_cmd_cols, 0xf0, 1, 2, 3, 4, 5, 6, 7}); // more than fit. the rest are characters
+  CHECK(n.indata_state == n.indata_state_norm);
+
+  // NDOTM_CMD_STRING, and raw parameters ahead of a string
+  Tx({0x27, ndotm_cmd_message, 'H', 'I', 0});
+  CHECK(n.buf[0] == 'H' && n.buf[2] == 0 && n.Mode == n.ModeStartScrollMessage);
+  Tx({0x27, ndotm_cmd_message});
+  for (int i = 0; i < 40; i++)
+    HostBoardRx('a' + i % 26);
+  CHECK(n.indata_state == n.indata_state_rx_string); // the rest is dropped up to the 0
+  HostBoardRx(0);
+  CHECK(n.buf[NDOTM_MSGLEN - 1] == 'a' + (NDOTM_MSGLEN - 1) % 26 && n.buf[NDOTM_MSGLEN] == 0);
+  CHECK(n.indata_state == n.indata_state_norm && n.Mode == n.ModeStartScrollMessage);
+
+  // unknown opcodes are dropped, and what follows is a character
+  Tx({0x27, 99, 'Q'});
+  CHECK(n.buf[0] == 'Q');
+  Tx({0x27, 0, 'R'});
+  CHECK(n.buf[0] == 'R');
+
+  // a raw command cut short gives up once the line is quiet
+  Tx({0x27, ndotm_cmd_char});
+  CHECK(n.indata_state == n.indata_state_rx_params);
+  Quiet(NDOTM_PKT_IDLE_MAX + 1);
+  CHECK(n.indata_state == n.indata_state_norm);
+  Tx({0x27, ndotm_cmd_char, 'S'});
+  CHECK(n.buf[0] == 'S');
+
+  // packets: anything goes inside, and a good crc runs every command
+  Packet({ndotm_cmd_data, 0x27, 0x27, 9, 10, 11});
+  CHECK(n.buf[4] == 0x27 && n.buf[3] == 0x27 && n.buf[0] == 11);
+  Packet({ndotm_cmd_col, 0, 0x27, ndotm_cmd_pixels, ndotm_pix_set | 0x1f, 0x40});
+  CHECK(n.buf[4] == 0x67 && n.buf[0] == (11 | 0x40));
+  Packet({ndotm_cmd_message, 'A', 'B', 0, ndotm_cmd_transition, 3});
+  CHECK(n.buf[1] == 'B' && n.transition_max == 3);
+  Packet({});
+  CHECK(n.indata_state == n.indata_state_norm);
+
+  // a bad crc drops the packet and everything up to the next one
+  Packet({ndotm_cmd_data, 1, 1, 1, 1, 1}, 2);
+  CHECK(n.indata_state == n.indata_state_pkt_hunt && n.buf[0] == 'A');
+  Tx({'X', 0x27, ndotm_cmd_char, 'Y'});
+  CHECK(n.buf[0] == 'A');
+  Packet({ndotm_cmd_char, 'Z', ndotm_cmd_rate, 7});
+  CHECK(n.buf[0] == 'Z' && n.scroll_rate_div == 7 && n.indata_state == n.indata_state_norm);
+
+  // ..or a reset, or a pause
+  Packet({ndotm_cmd_rate, 1}, 1);
+  Tx({0x27, ndotm_cmd_reset, 'r'});
+  CHECK(n.buf[0] == 'r');
+  Packet({ndotm_cmd_rate, 1}, 1);
+  Quiet(NDOTM_PKT_IDLE_MAX + 1);
+  Tx({'q'});
+  CHECK(n.buf[0] == 'q');
+
+  // too long for pkt_buf: counted through, then dropped
+  Tx({0x27, ndotm_cmd_packet, NDOTM_PKT_MAXLEN + 1});
+  for (int i = 0; i <= NDOTM_PKT_MAXLEN + 1; i++)
+    HostBoardRx(ndotm_cmd_reset);
+  CHECK(n.indata_state == n.indata_state_pkt_hunt);
+
+  // a packet cut short is given up on too
+  Tx({0x27, ndotm_cmd_reset});
+  Tx({0x27, ndotm_cmd_packet, 4, ndotm_cmd_char});
+  Quiet(NDOTM_PKT_IDLE_MAX + 1);
+  CHECK(n.indata_state == n.indata_state_norm);
+
+  // a byte that arrives ahead of the parameters it belongs with is still
+  // counted against the command, not taken as a character
+  Tx({0x27, ndotm_cmd_pixels, ndotm_pix_set | 0x1f});
+  CHECK(n.indata_state == n.indata_state_rx_params);
+  Tx({0x7f});
+  CHECK(n.indata_state == n.indata_state_norm);
+
+  // crc: known answers for CRC-8/SMBUS
+  {
+    uint8_t crc = 0;
+    for (const char *p = "123456789"; *p; p++)
+      crc = ndotm_crc8(crc, *p);
+    CHECK(crc == 0xf4);
+  }
+
+  return HostTestDone("protocol");
+}
@@ -0,0 +1,178 @@
+/*
+  The driver's queue and frame mailbox against a simulated board: queued
+  commands all arrive and in order, a queued command makes the next frame
+  go out whole, frames_sent only counts frames that sent something. Then
+  end to end latency and the drop rate with frames posted faster than
+  the link can take them.
+*/
+
+#include <initializer_list>
+#include "HostTest.h"
+#include "HostSim.h"
+#include "HostBoard.h"
+#define private public // to see what the board shows
+#include "NovaDotMatrix.h"
+#undef private
+#include "NovaDotMatrixCommands.h"
+#include "NovaDotMatrixDriver.h"
+
+NovaDotMatrix novadotmatrix;
+ATtinyTimer attinytimer;
+static NovaDotMatrix &n = novadotmatrix;
+static NovaDotMatrixDriver d;
+
+#define LOOP_US 100 // time round the sketch's loop()
+
+static uint8_t rx[512];
+static uint16_t rx_len;
+
+static void Rx(uint8_t c) {
+  if (rx_len < sizeof(rx))
+    rx[rx_len++] = c;
+}
+
+static bool Shows(const uint8_t *dat) {
+  // ndotm_cmd_data order is buf[] backwards
+  for (uint8_t c = 0; c < NDM_NUMCOLS; c++) {
+    if (n.buf[NDOTM_LASTCOL - c] != dat[c])
+      return false;
+  }
+  return true;
+}
+
+static void Drain(void) {
+  while (d.Poll())
+    delayMicroseconds(LOOP_US);
+  delay(NDM_INTERCMD_DELAY_MS); // for the board to take the last byte
+}
+
+static void Frame(uint32_t k, bool scrolling, uint8_t *dat) {
+  // either a column moving along each frame, or all new
+  for (uint8_t c = 0; c < NDM_NUMCOLS; c++) {
+    if (scrolling)
+      dat[c] = (uint8_t)((k + c) * 37 + ((k + c) >> 3)) & 0x7f;
+    else
+      dat[c] = (uint8_t)(k * 53 + c * 29 + (k >> 2)) & 0x7f;
+  }
+}
+
+static void Ordered(void) {
+  uint8_t a[NDM_NUMCOLS] = {1, 2, 3, 4, 5};
+  uint8_t col[] = {ndotm_cmd_escape_code, ndotm_cmd_col, 2, 0x55};
+  uint8_t dwell[3];
+  uint16_t found = 0, sent;
+
+  d.PostFrame(a);
+  Drain();
+  CHECK(Shows(a) && d.frames_sent == 1);
+
+  // the same frame again changes nothing, so isn't counted
+  d.PostFrame(a);
+  Drain();
+  CHECK(d.frames_sent == 1);
+
+  // a command changes the display. the same frame must go out again
+  CHECK(d.Queue(col, sizeof(col)));
+  Drain();
+  CHECK(!Shows(a));
+  d.PostFrame(a);
+  Drain();
+  CHECK(Shows(a) && d.frames_sent == 2);
+
+  // commands always arrive, in order, however many frames come past
+  rx_len = 0;
+  host_board_byte_hook = Rx;
+  for (uint8_t v = 1; v <= 10; v++) {
+    uint8_t f[NDM_NUMCOLS];
+
+    dwell[0] = ndotm_cmd_escape_code;
+    dwell[1] = ndotm_cmd_dwell;
+    dwell[2] = v;
+    CHECK(d.Queue(dwell, sizeof(dwell)));
+    Frame(v, false, f);
+    d.PostFrame(f);
+    for (uint8_t i = 0; i < 3; i++) {
+      d.Poll();
+      delayMicroseconds(LOOP_US);
+    }
+  }
+  Drain();
+  host_board_byte_hook = 0;
+  for (uint16_t i = 0; i + 2 < rx_len; i++) {
+    if (rx[i] == ndotm_cmd_escape_code && rx[i + 1] == ndotm_cmd_dwell && rx[i + 2] == found + 1)
+      found++;
+  }
+  CHECK(found == 10 && n.dwell_div == 10);
+  sent = d.frames_sent;
+  CHECK(sent > 2 && sent + d.frames_dropped <= 2 + 10);
+}
+
+static void Load(uint32_t every_us, bool scrolling) {
+  //
+  // post a new frame every every_us for two seconds, calling Poll() in
+  // between, and time each frame from PostFrame() to the board showing it
+  //
+  static uint8_t frames[64][NDM_NUMCOLS];
+  static uint64_t posted_at[64];
+  uint32_t posted = 0, shown = 0, dropped;
+  uint64_t start = host_now_us, next = host_now_us, lat, lat_sum = 0, lat_max = 0;
+  int32_t last_seen = -1;
+
+  d.ForgetFrame();
+  d.frames_sent = d.frames_dropped = 0;
+  while (host_now_us - start < 2000000) {
+    if (host_now_us >= next) {
+      Frame(posted, scrolling, frames[posted % 64]);
+      posted_at[posted % 64] = host_now_us;
+      d.PostFrame(frames[posted % 64]);
+      posted++;
+      next += every_us;
+    }
+    d.Poll();
+    delayMicroseconds(LOOP_US);
+
+    // newest first, so one shown late isn't counted for an older one
+    for (int32_t k = posted - 1; k > last_seen && k >= (int32_t)posted - 64; k--) {
+      if (Shows(frames[k % 64])) {
+        lat = host_now_us - posted_at[k % 64];
+        lat_sum += lat;
+        if (lat > lat_max)
+          lat_max = lat;
+        shown++;
+        last_seen = k;
+        break;
+      }
+    }
+  }
+  Drain();
+  dropped = d.frames_dropped;
+
+  printf("  every %5.1f ms, %-9s posted %3u shown %3u dropped %3u (%2.0f%%), latency mean %5.1f ms max %5.1f ms\n",
+         every_us / 1000.0, scrolling ? "scrolling" : "all new", posted, shown, dropped,
+         100.0 * dropped / posted, shown ? lat_sum / 1000.0 / shown : 0.0, lat_max / 1000.0);
+
+  // the last one always gets there
+  CHECK(Shows(frames[(posted - 1) % 64]));
+  CHECK(shown > 0 && shown + dropped <= posted);
+  // at worst: the frame that had just started, then this one, whole
+  CHECK(lat_max <= d.WireMicros(2 * NDM_TX_LEN) + every_us);
+}
+
+int main(void) {
+  HostReset();
+  HostBoardStart(10, 11, 12);
+  memset(&d, 0, sizeof(d));
+  d.clk_pin  = 10;
+  d.data_pin = 11;
+  d.Setup();
+
+  Ordered();
+
+  printf("queue: latency and drops, %lu us a byte on the wire\n", (unsigned long)d.WireMicros(1));
+  for (bool scrolling : {true, false}) {
+    Load(200000, scrolling); // easy
+    Load(30000, scrolling);  // about a frame's bytes
+    Load(10000, scrolling);  // overloaded
+  }
+  return HostTestDone("queue");
+}
@@ -0,0 +1,153 @@
+/*
+  ATtinyTimer's task list: order, catch up and the lag counts, then the
+  same counts and the NDOTM_PROFILE table read back over the diag line
+  by the driver.
+*/
+
+#include "HostTest.h"
+#include "HostSim.h"
+#include "HostBoard.h"
+#include "ATtinyTimer.h"
+#define private public // the tests look at the task list
+#include "NovaDotMatrix.h"
+#undef private
+#include "NovaDotMatrixCommands.h"
+#include "NovaDotMatrixDriver.h"
+
+NovaDotMatrix novadotmatrix;
+ATtinyTimer attinytimer;
+static ATtinyTimer &t = attinytimer;
+
+static char order[64];
+static uint8_t order_len;
+static uint8_t a_runs, b_runs, c_runs;
+
+static uint8_t TaskA(void) { a_runs++; order[order_len++ & 63] = 'a'; return 3; }
+static uint8_t TaskB(void) { b_runs++; order[order_len++ & 63] = 'b'; return 1; }
+static uint8_t TaskC(void) { c_runs++; order[order_len++ & 63] = 'c'; return 0; } // one shot
+static uint8_t TaskX(void) { order[order_len++ & 63] = 'x'; return 2; }
+static uint8_t TaskY(void) { order[order_len++ & 63] = 'y'; return 2; }
+static uint8_t TaskZ(void) { order[order_len++ & 63] = 'z'; return 2; }
+
+static void Tick(uint8_t n) {
+  while (n--) {
+    TIMER1_OVF_vect();
+    t.Loop();
+  }
+}
+
+static void Scheduler(void) {
+  uint8_t a, b, x, y;
+
+  t.Setup();
+  order_len = 0;
+  a = t.AddTask(TaskA, 3);
+  b = t.AddTask(TaskB, 1);
+  t.AddTask(TaskC, 5);
+  Tick(3);
+  CHECK(order_len == 4 && !memcmp(order, "bbab", 4)); // a was due at 3 before b came back for it
+  Tick(27);
+  CHECK(a_runs == 10 && b_runs == 30 && c_runs == 1);
+
+  // a one shot leaves its slot free
+  CHECK(t.AddTask(TaskC, 1) != ATT_NO_TASK);
+  Tick(1);
+  CHECK(c_runs == 2);
+
+  // taking one out leaves the rest on time
+  t.RemoveTask(a);
+  t.RemoveTask(a); // not there any more
+  order_len = 0;
+  Tick(6);
+  CHECK(a_runs == 10 && b_runs == 37 && order_len == 6);
+  t.RemoveTask(b);
+
+  // due on the same tick: in the order they were added, and they stay that way
+  order_len = 0;
+  x = t.AddTask(TaskX, 2);
+  y = t.AddTask(TaskY, 2);
+  t.AddTask(TaskZ, 2);
+  Tick(4);
+  CHECK(order_len == 6 && !memcmp(order, "xyzxyz", 6));
+  t.RemoveTask(y);
+  order_len = 0;
+  Tick(2);
+  CHECK(order_len == 2 && !memcmp(order, "xz", 2));
+  t.RemoveTask(x);
+
+  // full up
+  for (uint8_t i = 0; i < ATT_MAX_TASKS; i++)
+    t.AddTask(TaskC, 200);
+  CHECK(t.AddTask(TaskC, 1) == ATT_NO_TASK);
+
+  // a slow Loop() catches up on every tick it missed, and it's counted
+  t.Setup();
+  a_runs = 0;
+  t.AddTask(TaskA, 3);
+  for (uint8_t i = 0; i < 30; i++)
+    TIMER1_OVF_vect();
+  t.Loop();
+  CHECK(a_runs == 10 && t.MaxBacklog == 30 && t.LagTicks == 29 && t.LostTicks == 0);
+  t.Loop(); // nothing new
+  CHECK(a_runs == 10 && t.LagTicks == 29);
+
+  // the ISR's count fills up rather than wrapping
+  for (uint16_t i = 0; i < 300; i++)
+    TIMER1_OVF_vect();
+  CHECK(ATtinyTimerTicks == 0xff);
+  t.Loop();
+  CHECK(t.LostTicks == 1 && t.MaxBacklog == 0xff);
+  t.ClearStats();
+  CHECK(!t.MaxBacklog && !t.LagTicks && !t.LostTicks);
+}
+
+static void Diag(void) {
+  // the board's own counts, read back the way the diag example does
+  NovaDotMatrixDriver d;
+  uint8_t buf[NDOTM_DIAG_PROFILE_LEN];
+  uint8_t n;
+
+  HostReset();
+  HostBoardStart(10, 11, 12);
+  memset(&d, 0, sizeof(d));
+  d.clk_pin  = 10;
+  d.data_pin = 11;
+  d.diag_pin = 12;
+  d.Setup();
+
+  t.MaxBacklog = 7;
+  t.LagTicks   = 0x1234;
+  t.LostTicks  = 2;
+  n = d.Diag(ndotm_diag_timer | NDOTM_DIAG_CLEAR, buf, NDOTM_DIAG_TIMER_LEN);
+  CHECK(n == NDOTM_DIAG_TIMER_LEN);
+  CHECK(buf[0] == ndotm_diag_timer && buf[1] == 7 && buf[2] == 0x34 && buf[3] == 0x12 && buf[4] == 2);
+  CHECK(t.LagTicks < 4 && !t.LostTicks); // only the ticks it missed while answering
+
+  // the board keeps time while it talks
+  delay(100);
+  n = d.Diag(ndotm_diag_timer, buf, NDOTM_DIAG_TIMER_LEN);
+  CHECK(n == NDOTM_DIAG_TIMER_LEN && buf[0] == ndotm_diag_timer && buf[4] == 0);
+
+  n = d.Diag(ndotm_diag_profile, buf, sizeof(buf));
+#ifdef NDOTM_PROFILE
+  CHECK(n == NDOTM_DIAG_PROFILE_LEN && buf[0] == ndotm_diag_profile && buf[1] == ndotm_prof_max);
+  for (uint8_t i = 0; i < ndotm_prof_max; i++) {
+    uint8_t *s = buf + 3 + i * NDOTM_DIAG_PROFILE_SITE_LEN;
+    uint16_t calls = s[0] | (s[1] << 8);
+    // what ran since the power up: every site but the demo and the effects
+    if (i == ndotm_prof_demo_manage || i == ndotm_prof_effect_step)
+      CHECK(calls == 0);
+    else
+      CHECK(calls > 0);
+  }
+#else
+  CHECK(n == 3 && buf[0] == ndotm_diag_profile && buf[1] == 0);
+#endif
+}
+
+int main(void) {
+  HostReset();
+  Scheduler();
+  Diag();
+  return HostTestDone("scheduler");
+}
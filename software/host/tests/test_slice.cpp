@@ -0,0 +1,44 @@
+/*
+  SliceCanvas() against a pixel at a time, at every bit offset, built
+  both ways (NDM_SLICE_WORDS 0 and 1) in CMakeLists.txt.
+*/
+
+#include "Arduino.h"
+#include "HostTest.h"
+#include "HostSim.h"
+#include "NovaDotMatrixDriver.h"
+
+#define WIDTH  61
+#define HEIGHT 11
+#define STRIDE ((WIDTH + 7) / 8)
+
+static uint8_t canvas[STRIDE * HEIGHT];
+
+static uint8_t Pixel(uint16_t x, uint16_t y) {
+  return (canvas[y * STRIDE + x / 8] >> (7 - x % 8)) & 1;
+}
+
+int main(void) {
+  NovaDotMatrixDriver d;
+  uint8_t dat[NDM_NUMCOLS], want;
+  char name[32];
+
+  HostReset();
+  for (uint16_t i = 0; i < sizeof(canvas); i++)
+    canvas[i] = random(256);
+
+  for (uint16_t y = 0; y + NDM_NUMROWS <= HEIGHT; y++) {
+    for (uint16_t x = 0; x + NDM_NUMCOLS <= WIDTH; x++) {
+      d.SliceCanvas(canvas, STRIDE, x, y, dat);
+      for (uint8_t c = 0; c < NDM_NUMCOLS; c++) {
+        // bit 6 the top row
+        want = 0;
+        for (uint8_t r = 0; r < NDM_NUMROWS; r++)
+          want |= Pixel(x + c, y + r) << (NDM_NUMROWS - 1 - r);
+        CHECK(dat[c] == want);
+      }
+    }
+  }
+  snprintf(name, sizeof(name), "slice words %d", NDM_SLICE_WORDS);
+  return HostTestDone(name);
+}
@@ -0,0 +1,195 @@
+/*
+  Command stream files (tools/NdmStreamFile.h): both versions play the
+  same as the PROGMEM stream they came from, entries come out where they
+  lie in the file, seeking, streams that don't make sense, and a long
+  entry through a driver into a board.
+*/
+
+#include <vector>
+#include <unistd.h>
+#include "HostTest.h"
+#include "HostSim.h"
+#include "HostBoard.h"
+#include "NovaDotMatrix.h"
+#include "NovaDotMatrixCommands.h"
+#include "NovaDotMatrixDriver.h"
+#include "NdmStreamFile.h"
+
+NovaDotMatrix novadotmatrix;
+ATtinyTimer attinytimer;
+
+static const uint8_t stream[] PROGMEM = {
+  NDM_STREAM_HEADER(4, NDM_STREAM_COMMANDS(4) + 7),
+  NDM_STREAM_ENTRY(0,  NDM_STREAM_ALL_PANELS, NDM_STREAM_COMMANDS(4)),
+  NDM_STREAM_ENTRY(10, 1,                     NDM_STREAM_COMMANDS(4) + 1),
+  NDM_STREAM_ENTRY(10, 2,                     NDM_STREAM_COMMANDS(4) + 4),
+  NDM_STREAM_ENTRY(25, NDM_STREAM_ALL_PANELS, NDM_STREAM_COMMANDS(4) + 6),
+  'A',
+  ndotm_cmd_escape_code, ndotm_cmd_char, ndotm_cmd_escape_code,
+  'B', 'C',
+  'D',
+};
+
+struct sent {
+  uint8_t panel;
+  const uint8_t *p;
+  uint64_t len;
+};
+
+static std::vector<sent> got;
+
+static void Send(uint8_t panel, const uint8_t *p, uint64_t len, void *) {
+  sent s = { panel, p, len };
+  got.push_back(s);
+}
+
+static const char *Save(const std::vector<uint8_t> &s) {
+  static char path[64];
+  FILE *f;
+
+  snprintf(path, sizeof(path), "/tmp/test_stream_%d.nds", (int)getpid());
+  f = fopen(path, "wb");
+  fwrite(s.data(), 1, s.size(), f);
+  fclose(f);
+  return path;
+}
+
+static void PutLe(std::vector<uint8_t> &s, uint64_t v, uint8_t len) {
+  while (len--) {
+    s.push_back(v & 0xff);
+    v >>= 8;
+  }
+}
+
+static std::vector<uint8_t> Wide(void) {
+  // the same stream, NDM_STREAM_VERSION_WIDE
+  std::vector<uint8_t> s;
+  uint64_t shift = NDM_STREAM_WIDE_HEADER_LEN + 4 * NDM_STREAM_WIDE_ENTRY_LEN - NDM_STREAM_COMMANDS(4);
+
+  s.push_back('N');
+  s.push_back('D');
+  s.push_back('S');
+  s.push_back(NDM_STREAM_VERSION_WIDE);
+  PutLe(s, 4, 4);
+  PutLe(s, sizeof(stream) + shift, 8);
+  for (uint8_t e = 0; e < 4; e++) {
+    const uint8_t *p = stream + NDM_STREAM_HEADER_LEN + e * NDM_STREAM_ENTRY_LEN;
+    s.insert(s.end(), p, p + 5);
+    PutLe(s, (p[5] | (p[6] << 8)) + shift, 8);
+  }
+  s.insert(s.end(), stream + NDM_STREAM_COMMANDS(4), stream + sizeof(stream));
+  return s;
+}
+
+static void Plays(const char *path) {
+  NdmStreamFile f;
+
+  CHECK(f.Open(path));
+  CHECK(f.entries == 4 && f.Time(3) == 25);
+
+  got.clear();
+  f.Seek(0);
+  CHECK(f.Play(5, Send, 0));
+  CHECK(got.size() == 1 && got[0].panel == NDM_STREAM_ALL_PANELS && got[0].len == 1 && got[0].p[0] == 'A');
+  CHECK(f.Play(24, Send, 0));
+  CHECK(got.size() == 3 && got[1].panel == 1 && got[1].len == 3 && got[2].panel == 2 && got[2].len == 2);
+  CHECK(got[1].p[2] == ndotm_cmd_escape_code && got[2].p[0] == 'B');
+  CHECK(!f.Play(25, Send, 0));
+  CHECK(got.size() == 4 && got[3].p[0] == 'D' && got[3].len == 1);
+
+  // straight out of the mapping: each entry's commands follow the last's
+  for (uint8_t i = 1; i < 4; i++)
+    CHECK(got[i].p == got[i - 1].p + got[i - 1].len);
+
+  // first at or after
+  got.clear();
+  f.Seek(10);
+  f.Play(10, Send, 0);
+  CHECK(got.size() == 2 && got[0].panel == 1);
+  got.clear();
+  f.Seek(11);
+  CHECK(!f.Play(1000, Send, 0) && got.size() == 1 && got[0].p[0] == 'D');
+  f.Seek(26);
+  CHECK(!f.Play(1000, Send, 0) && got.size() == 1);
+  unlink(path);
+}
+
+static void Bad(void) {
+  std::vector<uint8_t> s(stream, stream + sizeof(stream));
+  NdmStreamFile f;
+  const char *path;
+
+  CHECK(!f.Open("/nonexistent.nds"));
+
+  s[2] = 'X';
+  CHECK(!f.Open(Save(s)));
+  s[2] = 'S';
+  s[3] = 3;
+  CHECK(!f.Open(Save(s)));
+  s[3] = NDM_STREAM_VERSION;
+
+  // commands cut short
+  s.pop_back();
+  CHECK(!f.Open(Save(s)));
+  s.push_back('D');
+
+  // an index running into the end
+  s[4] = 200;
+  CHECK(!f.Open(Save(s)));
+  s[4] = 4;
+
+  // offsets out of order stop it there
+  s[NDM_STREAM_HEADER_LEN + 2 * NDM_STREAM_ENTRY_LEN + 5] = 0;
+  path = Save(s);
+  CHECK(f.Open(path));
+  got.clear();
+  f.Seek(0);
+  CHECK(!f.Play(1000, Send, 0) && got.size() == 1);
+  unlink(path);
+}
+
+static void ToBoard(uint8_t panel, const uint8_t *p, uint64_t len, void *arg) {
+  (void)panel;
+  NdmStreamWrite(*(NovaDotMatrixDriver *)arg, p, len);
+}
+
+static void Driver(void) {
+  // an entry longer than WriteBuf() takes at once
+  std::vector<uint8_t> s;
+  NovaDotMatrixDriver d;
+  NdmStreamFile f;
+  const char *path;
+
+  s.push_back('N');
+  s.push_back('D');
+  s.push_back('S');
+  s.push_back(NDM_STREAM_VERSION);
+  PutLe(s, 1, 2);
+  PutLe(s, NDM_STREAM_COMMANDS(1) + 300, 2);
+  PutLe(s, 0, 4);
+  s.push_back(NDM_STREAM_ALL_PANELS);
+  PutLe(s, NDM_STREAM_COMMANDS(1), 2);
+  for (uint16_t i = 0; i < 300; i++)
+    s.push_back('a' + i % 26);
+  path = Save(s);
+
+  HostReset();
+  HostBoardStart(10, 11, 12);
+  memset(&d, 0, sizeof(d));
+  d.clk_pin  = 10;
+  d.data_pin = 11;
+  d.Setup();
+  CHECK(f.Open(path));
+  f.Seek(0);
+  CHECK(!f.Play(0, ToBoard, &d));
+  CHECK(host_board_bytes == 300 && !host_board_lost);
+  unlink(path);
+}
+
+int main(void) {
+  Plays(Save(std::vector<uint8_t>(stream, stream + sizeof(stream))));
+  Plays(Save(Wide()));
+  Bad();
+  Driver();
+  return HostTestDone("stream");
+}
@@ -11,28 +11,25 @@
 #include <avr/interrupt.h>
 #include "ATtinyTimer.h"
 #include "NovaDotMatrix.h"
+#include "NovaDotMatrixCommands.h"
 
 
 extern ATtinyTimer attinytimer;
 
-volatile uint8_t ATtinyTimerFastFlags;
-volatile uint8_t ATtinyTimerFiveHundredHzCtr;
-uint8_t ATtinyTimerFiveHundredHzDiv;
-
-volatile uint8_t ATtinyOneHundredHzFlags;
+volatile uint8_t ATtinyTimerTicks;
 
 
 void ATtinyTimer::Setup(void) { 
   // called once to setup the periodic timer interrupt
   
-  //  COUNTERS                  DIVISORS                      INITIALIZERS
-  ATtinyTimerFiveHundredHzCtr = ATtinyTimerFiveHundredHzDiv = ATT_FIVE_HUNDRED_HZ_DIV;
-  OneHundredHzCtr             = OneHundredHzDiv             = ATT_ONEHUNDRED_HZ_DIV;
-  FiftyHzCtr                  = FiftyHzDiv                  = ATT_FIFTY_HZ_DIV;
-  TenHzCtr                    = TenHzDiv                    = ATT_TENHZDIV;
-  OneHzCtr                    = OneHzDiv                    = ATT_ONEHZDIV;
+  // no tasks yet
+  for (uint8_t i = 0; i < ATT_MAX_TASKS; i++)
+    task_fn[i] = 0;
+  task_head = ATT_NO_TASK;
+
   // this one outside the object for dereference speed
-  ATtinyTimerFastFlags        = OneHzFlags                  = 0b00000000;
+  ATtinyTimerTicks            = 0;
+  ClearStats();
 
   TIMSK &= ~_BV(TOIE1); // Turn this interrupt off
 
@@ -46,55 +43,126 @@ void ATtinyTimer::Setup(void) {
 
 }
 
+void ATtinyTimer::Insert(uint8_t t, uint8_t ticks) {
+  // put task t into the list ticks from now. 
+  // Tasks due on the same tick run in the order they were put in.
+  uint8_t prev = ATT_NO_TASK;
+  uint8_t cur  = task_head;
+
+  while (cur != ATT_NO_TASK && ticks >= task_delta[cur]) {
+    ticks -= task_delta[cur];
+    prev   = cur;
+    cur    = task_next[cur];
+  }
+
+  task_delta[t] = ticks;
+  task_next[t]  = cur;
+  if (cur != ATT_NO_TASK)
+    task_delta[cur] -= ticks;
+
+  if (prev == ATT_NO_TASK)
+    task_head = t;
+  else
+    task_next[prev] = t;
+}
+
+uint8_t ATtinyTimer::AddTask(ATtinyTimerTask fn, uint8_t ticks) {
+  for (uint8_t t = 0; t < ATT_MAX_TASKS; t++) {
+    if (!task_fn[t]) {
+      task_fn[t] = fn;
+      Insert(t, ticks);
+      return t;
+    }
+  }
+  return ATT_NO_TASK;
+}
+
+void ATtinyTimer::RemoveTask(uint8_t t) {
+  uint8_t prev = ATT_NO_TASK;
+  uint8_t cur  = task_head;
+
+  while (cur != ATT_NO_TASK && cur != t) {
+    prev = cur;
+    cur  = task_next[cur];
+  }
+  if (cur == ATT_NO_TASK)
+    return; // not in the list
+
+  // whoever was behind it is now due that much later after the one ahead
+  if (task_next[t] != ATT_NO_TASK)
+    task_delta[task_next[t]] += task_delta[t];
+
+  if (prev == ATT_NO_TASK)
+    task_head = task_next[t];
+  else
+    task_next[prev] = task_next[t];
+
+  task_fn[t] = 0;
+}
+
+void ATtinyTimer::ClearStats(void) {
+  MaxBacklog = 0;
+  LagTicks   = 0;
+  LostTicks  = 0;
+}
+
 void ATtinyTimer::Loop(void) {
-  // we just set a bunch of flags depending on how much time has elapsed.
-  // The main Loop() watches for these and does things a
+  // Run whatever tasks have come due since the last time we were called.
+  // The tasks do things
   // like scanning the multiplex display and scrolling, etc...
-  // The main Loop needs to clear these flags
+  // If we were slow getting here, run every tick we missed so
+  // scrolling and dwell keep time.
+  uint8_t ticks;
   
   DISABLE_TIMER_IRUPS;
-  if (ATtinyTimerFastFlags & ATT_FAST_FLAG_BIT) { 
-    // go look what TCCR1 was set to in Setup()
-    // to find out what 'fast' is
-    ATtinyTimerFastFlags &= ~ATT_FAST_FLAG_BIT;
-    ENABLE_TIMER_IRUPS;
-
-    // 500 HZ
-    if (ATtinyTimerFiveHundredHzCtr) {
-      ATtinyTimerFiveHundredHzCtr--;
-
-      // 100 HZ
-      if (!(--OneHundredHzCtr)) {
-        OneHundredHzCtr = OneHundredHzDiv;
-        OneHundredHzFlag = true;
-        
-        // 50 HZ
-        if (!(--FiftyHzCtr)) {
-          FiftyHzCtr = FiftyHzDiv;
-          FiftyHzFlag = true;
-        }
-
-        // 10 HZ
-        if (!(--TenHzCtr)) {
-          TenHzCtr = TenHzDiv;
-          TenHzFlags |= 0b11111111; 
-        }
-        // 1 HZ
-        if (!(--OneHzCtr)) {
-          OneHzCtr = OneHzDiv;
-          OneHzFlag = true;
-        }
-      }
-    }
-  }
+  ticks = ATtinyTimerTicks;
+  ATtinyTimerTicks = 0;
   ENABLE_TIMER_IRUPS;
 
+  if (!ticks)
+    return;
+
+  // keep score
+  if (ticks > MaxBacklog)
+    MaxBacklog = ticks;
+  if (LagTicks <= (uint16_t)(0xffff - ticks))
+    LagTicks += ticks - 1;
+  if (ticks == 0xff && LostTicks != 0xff)
+    LostTicks++; // count filled up, so some went missing
+
+  while (ticks--)
+    Tick();
+
+}
+
+void ATtinyTimer::Tick(void) {
+  // one fast tick. go look what TCCR1 was set to in Setup()
+  // to find out what 'fast' is
+  uint8_t t, ticks;
+
+  if (task_head == ATT_NO_TASK)
+    return;
+
+  if (task_delta[task_head])
+    task_delta[task_head]--;
+
+  while (task_head != ATT_NO_TASK && !task_delta[task_head]) {
+    t         = task_head;
+    task_head = task_next[t];
+
+    ticks = task_fn[t]();
+    if (ticks)
+      Insert(t, ticks);
+    else
+      task_fn[t] = 0; // one shot, or done
+  }
 }
 
 ISR (TIMER1_OVF_vect) {
   // interrupt service routine for Timer0
   // Gets called 1000 times per second.
-  //attinytimer.FastFlags |= 0b11111111; // indicate to everyone we've been here
-  ATtinyTimerFastFlags |= 0b11111111;
+  // count it. Loop() will catch up
+  NDOTM_PROFILE_SITE(ndotm_prof_isr_timer);
+  if (ATtinyTimerTicks != 0xff)
+    ATtinyTimerTicks++;
 }
-
@@ -1,16 +1,20 @@
 #if 1
 #ifndef ATtinyTimer_h
 #define ATtinyTimer_h
+#include <stdint.h>
 
 // The ATtinyTimer class
 
-#define ATT_FAST_FLAG_BIT 0b10000000
-// some of these were moved out of the class to speed things up
-extern volatile uint8_t ATtinyTimerFastFlags;
-extern volatile uint8_t ATtinyTimerFiveHundredHzCtr ; 
-extern uint8_t ATtinyTimerFiveHundredHzDiv ; // ISR resets Ctr to Div when Flag is cleared
-#define ATT_FIVE_HUNDRED_HZ_SHORTDIV 1
-#define ATT_FIVE_HUNDRED_HZ_DIV 2
+// fast ticks the ISR has counted that Loop() hasn't run yet.
+// outside the class for dereference speed
+extern volatile uint8_t ATtinyTimerTicks;
+
+// A task is called from Loop() when it comes due. It returns how many fast 
+// ticks until it wants to be called again, or 0 if it is done.
+typedef uint8_t (*ATtinyTimerTask)(void);
+
+#define ATT_MAX_TASKS 6
+#define ATT_NO_TASK   0xff
 
 
 class ATtinyTimer
@@ -20,28 +24,27 @@ class ATtinyTimer
     void Loop(void); 
     volatile bool triggered; // indicates if function has been called
 
-    // indicates a certain amount of time has passed...
-
-    uint8_t OneHundredHzCtr ;
-    uint8_t OneHundredHzDiv ;
-    volatile bool OneHundredHzFlag;
-#define ATT_ONEHUNDRED_HZ_DIV 11
-
-    uint8_t FiftyHzCtr ;
-    uint8_t FiftyHzDiv ;
-    volatile bool FiftyHzFlag;
-#define ATT_FIFTY_HZ_DIV 1
-
-    uint8_t TenHzCtr ;
-    uint8_t TenHzDiv ;
-    volatile uint8_t TenHzFlags;
-#define ATT_TENHZDIV        10
-
-    uint8_t OneHzCtr;
-    uint8_t OneHzDiv;
-    volatile bool OneHzFlag;
-    volatile uint8_t OneHzFlags;
-#define ATT_ONEHZDIV        100
+    // run fn after ticks fast ticks. returns the task number, or ATT_NO_TASK if full
+    uint8_t AddTask(ATtinyTimerTask fn, uint8_t ticks);
+    void RemoveTask(uint8_t);
+
+    // how well Loop() is keeping up
+    uint8_t MaxBacklog;  // most ticks we've had to catch up on at once
+    uint16_t LagTicks;   // ticks that ran late, all told
+    uint8_t LostTicks;   // times the ISR's count filled up, so ticks went missing
+    void ClearStats(void);
+
+  private:
+    void Tick(void);
+    void Insert(uint8_t, uint8_t);
+
+    // Tasks are kept in a list in the order they come due. Each one 
+    // holds how many ticks after the one ahead of it it is due, so each
+    // tick only has to count down the one at the head.
+    ATtinyTimerTask task_fn[ATT_MAX_TASKS];
+    uint8_t task_delta[ATT_MAX_TASKS];
+    uint8_t task_next[ATT_MAX_TASKS];
+    uint8_t task_head;
 
 }; 
 
@@ -0,0 +1,53 @@
+
+#ifndef FONTLATIN1
+
+// Latin-1 characters for the 5x7 font, the ones most likely to turn up.
+// Sorted by code so GetFont() can binary search them. Each is 
+//   code, what to show in the 3x5 font instead, 5 columns as in font_5x7_2
+// 33 of them at 7 bytes is 231 bytes of flash.
+
+#include <avr/pgmspace.h> // to get PROGMEM typedefs
+
+#define FONT_LATIN1_ENTRY_LEN 7
+
+const PROGMEM uint8_t font_latin1[] = {
+0xA1, '!', 0x00, 0x00, 0x7D, 0x00, 0x00, // ¡
+0xA3, 'L', 0x48, 0x3E, 0x49, 0x41, 0x22, // £
+0xB0, 'o', 0x06, 0x09, 0x09, 0x06, 0x00, // °
+0xB1, '+', 0x44, 0x44, 0x5F, 0x44, 0x44, // ±
+0xB5, 'u', 0x7C, 0x20, 0x20, 0x1C, 0x20, // µ
+0xBF, '?', 0x20, 0x40, 0x45, 0x48, 0x30, // ¿
+0xC4, 'A', 0x79, 0x14, 0x14, 0x14, 0x79, // Ä
+0xC5, 'A', 0x70, 0x2A, 0x25, 0x2A, 0x70, // Å
+0xC7, 'C', 0x0E, 0x51, 0x71, 0x11, 0x0A, // Ç
+0xC9, 'E', 0x7C, 0x54, 0x56, 0x55, 0x44, // É
+0xD1, 'N', 0x7E, 0x09, 0x12, 0x21, 0x7C, // Ñ
+0xD6, 'O', 0x39, 0x44, 0x44, 0x44, 0x39, // Ö
+0xD7, 'x', 0x22, 0x14, 0x08, 0x14, 0x22, // ×
+0xDC, 'U', 0x3D, 0x40, 0x40, 0x40, 0x3D, // Ü
+0xDF, 's', 0x7E, 0x09, 0x49, 0x36, 0x00, // ß
+0xE0, 'a', 0x20, 0x55, 0x56, 0x54, 0x78, // à
+0xE1, 'a', 0x20, 0x54, 0x56, 0x55, 0x78, // á
+0xE2, 'a', 0x20, 0x56, 0x55, 0x56, 0x78, // â
+0xE4, 'a', 0x20, 0x55, 0x54, 0x55, 0x78, // ä
+0xE7, 'c', 0x0C, 0x52, 0x72, 0x12, 0x00, // ç
+0xE8, 'e', 0x38, 0x55, 0x56, 0x54, 0x18, // è
+0xE9, 'e', 0x38, 0x54, 0x56, 0x55, 0x18, // é
+0xEA, 'e', 0x38, 0x56, 0x55, 0x56, 0x18, // ê
+0xEB, 'e', 0x38, 0x55, 0x54, 0x55, 0x18, // ë
+0xED, 'i', 0x00, 0x48, 0x7A, 0x41, 0x00, // í
+0xEF, 'i', 0x00, 0x49, 0x78, 0x41, 0x00, // ï
+0xF1, 'n', 0x7A, 0x11, 0x0A, 0x09, 0x70, // ñ
+0xF3, 'o', 0x38, 0x44, 0x46, 0x45, 0x38, // ó
+0xF4, 'o', 0x38, 0x46, 0x45, 0x46, 0x38, // ô
+0xF6, 'o', 0x38, 0x45, 0x44, 0x45, 0x38, // ö
+0xF7, ':', 0x08, 0x08, 0x2A, 0x08, 0x08, // ÷
+0xFA, 'u', 0x3C, 0x40, 0x42, 0x21, 0x7C, // ú
+0xFC, 'u', 0x3C, 0x41, 0x40, 0x21, 0x7C  // ü
+};
+
+#define FONT_LATIN1_ENTRIES (sizeof(font_latin1) / FONT_LATIN1_ENTRY_LEN)
+
+#define FONTLATIN1
+
+#endif
@@ -8,18 +8,22 @@
 #include "Arduino.h"               // pull in regular Arduino cruft
 #include "FontAlphaNum57.h"        // 5x7 fonts
 #include "FontAlphaNum35.h"        // 3x5 fonts
+#include "FontLatin1.h"            // beyond ASCII
+#include "TransitionMasks.h"       // for ndotm_cmd_transition_fx
 #include "avr/interrupt.h"         // we findout about incoming data via interrupts
+#include "avr/eeprom.h"            // playlist lives here
 
-#include "ATtinytimer.h"           // Interface to ATtiny's timer hardware
+#include "ATtinyTimer.h"           // Interface to ATtiny's timer hardware
 
 #define NDOTM_COMPILE_DEMO         // save space if you don't need the demo mode
 //#define NDOTM_FORCEDEMO            // no pin check on reset
+#define NDOTM_LATIN1               // accented letters in the 5x7 font. about 230 bytes
 #include "NovaDotMatrix.h"         // pull in class definitions
 
 #include "NovaDotMatrixCommands.h" // command our master can send us
 
 extern ATtinyTimer attinytimer;
-extern NovaDotMatrix novadotmatrix;
+NDOTM_INSTANCE_STORAGE NovaDotMatrix *ndotm_instance;
 
 
 void NovaDotMatrix::Setup(void)
@@ -60,6 +64,7 @@ void NovaDotMatrix::Setup(void)
 
      and another pin that is a data..
      */
+  ndotm_instance = this; // for the tasks and interrupts
 
   pinMode(NDOTM_CLK_IN_PIN    , INPUT);     // clock signal from our master
   pinMode(NDOTM_BLANK_DATOUT_PIN   , OUTPUT);    //
@@ -69,13 +74,28 @@ void NovaDotMatrix::Setup(void)
   pinMode(NDOTM_BLANK_DATOUT_PIN, OUTPUT);    // pin that turns off the display while we are shifting
 
   indata_available = false;                              // input data from master available
+#ifdef NDOTM_RX_USI
+  indata_cur_bit   = 0;                                  // USI counter starts at 0
+#else
   indata_cur_bit   = 7;                                  // current bit from master
+#endif
   indata           = 0;                                  // current data
+  indata_raw       = 0;
   indata_state     = indata_state_norm;
   indata_port      = digitalPinToPort(NDOTM_CLK_IN_PIN);
   indata_idle_ctr  = 0;
+  last_char_was_esc = false;
+  ctr              = 0;
+  last_cmd         = 0;
+  pkt_idle_ctr     = 0;
+  counter_val      = 0;
+  counter_flags    = 0;
+  playlist_count   = 0;
+  utf8_left        = 0;
 
   shift_dir        = 0;
+  scroll_dir       = ndotm_scroll_left;
+  effect           = ndotm_effect_off;
 
   digitalWrite(NDOTM_SR_DAT_PIN,1);
   digitalWrite(NDOTM_SR_CLK_PIN,1);
@@ -89,6 +109,9 @@ void NovaDotMatrix::Setup(void)
   scroll_rate_div    = scroll_rate_ctr = NDOTM_SCROLLRATE_VAL;
   dwell_div          = dwell_ctr       = NDOTM_DWELL_VAL;
   transition_max     = transition_ctr  = 0;
+#ifdef NDOTM_TRANSITION_FX
+  transition_fx      = ndotm_fx_cut;
+#endif
   col_ctr            = scrollstep      = 0;
   por_ctr            = 0;
   pin_end_is_top     = false;
@@ -98,6 +121,9 @@ void NovaDotMatrix::Setup(void)
   buf_contents       = NDOTM_BUF_CONTENTS_ASCII;
   cur_font           = cur_font_5x7;
   txt_curp = (char *)buf;
+#ifdef NDOTM_PROFILE
+  NdotmProfClear();
+#endif
 
   pinMode(NDOTM_DAT_IN_PIN    , INPUT_PULLUP);     // data from our master
   delay(250);// wait a little while for things to settle
@@ -114,8 +140,17 @@ void NovaDotMatrix::Setup(void)
   } else
   {
     // no demo. listen to clk and datain
+#ifdef NDOTM_RX_USI
+    // USI in two-wire mode clocked by CLK_IN (USCK), shifting DAT_IN (DI) on 
+    // the rising edge. Three-wire mode would drive DO, which is our blanking 
+    // pin. The 4 bit counter counts both clock edges so it overflows once 
+    // per byte. DAT_IN stays an input so the USI never pulls it low.
+    USICR              = _BV(USIOIE) | _BV(USIWM1) | _BV(USICS1);
+    USISR              = _BV(USISIF) | _BV(USIOIF) | _BV(USIPF); // clear flags, counter to 0
+#else
     PCMSK              |= NDOTM_CLK_IN_BIT; // CLK from master causes interrupts
     GIMSK              |= 0b00100000;      // Enable interrupts
+#endif
   }
 #endif
 
@@ -130,25 +165,63 @@ void NovaDotMatrix::Setup(void)
 
   for (uint8_t c = 0; c < NDOTM_NUMCOLS; c++) {
     // write all on as we go into scan
-    coldata[c] = 0b01111111;
+    coldata[c] = NDOTM_ALLROWS;
   }
 
   attinytimer.Setup();
 
+  // everything that happens on a schedule
+  attinytimer.AddTask(RefreshTask, NDOTM_REFRESH_TICKS);
+  attinytimer.AddTask(IdleTask,    NDOTM_IDLE_TICKS);
+  attinytimer.AddTask(ScrollTask,  NDOTM_SCROLL_TICKS);
+#ifdef NDOTM_COMPILE_DEMO
+  if (demo)
+    attinytimer.AddTask(DemoTask,  NDOTM_DEMO_TICKS);
+#endif
+
   sei();
 }
 
 #ifdef NDOTM_COMPILE_DEMO
 static void DemoManage(void);
 static uint8_t GetRandomGraph(void);
+
+uint8_t NovaDotMatrix::DemoTask(void) {
+  DemoManage();
+  return NDOTM_DEMO_TICKS;
+}
 #endif
 
+uint8_t NovaDotMatrix::RefreshTask(void) {
+  // most of the common work done no matter what state we are in...
+  ndotm_instance->WriteNextCol(); // Most of the work is done in WriteNextCol()
+
+  if (ndotm_instance->col_num_leds_on <= 3)
+    // bit of a brightness leveling hack..
+    // mitigate uneven brightness issues...
+    // don't leave on as long since fewer leds are on..
+    // otherwise they'll appear brighter due to current suck.
+    // TODO: This can be obviated in the next rev of hardware by putting
+    // the series resistors in the right place
+    return NDOTM_REFRESH_SHORT_TICKS;
+
+  return NDOTM_REFRESH_TICKS;
+}
+
+uint8_t NovaDotMatrix::ScrollTask(void) {
+  ndotm_instance->ScrollAndDwellManage();
+  return NDOTM_SCROLL_TICKS;
+}
+
+uint8_t NovaDotMatrix::IdleTask(void) {
+  ndotm_instance->IdleManage();
+  return NDOTM_IDLE_TICKS;
+}
+
 void NovaDotMatrix::Chores(void) {
         ProcessInData();
         attinytimer.Loop();
-        ScrollAndDwellManage();
         ProcessInData();
-        CommonLoopChores();
 }
 
 void NovaDotMatrix::Loop()
@@ -159,8 +232,8 @@ void NovaDotMatrix::Loop()
        Depends on the attinytimer library
 
        Everything is timed. We don't do anything more frequently than 
-       1/200th of a second.. We watch flags set by a periodic
-       interrupt (attinytimer), which will sequence all the necessary events
+       1/200th of a second.. Tasks registered with the periodic
+       interrupt (attinytimer) sequence all the necessary events
        This is the top loop which sets the basic behavior. 
        It is expected that this is called at 200hz (50ms) rate
        Each column is refreshed at this rate.
@@ -177,6 +250,12 @@ void NovaDotMatrix::Loop()
 
       case ModeStartTransition:
         Chores();
+#ifdef NDOTM_TRANSITION_FX
+        if (transition_fx != ndotm_fx_cut) {
+          FxStart();
+          Mode = ModeInTransition;
+        } else
+#endif
         if (transition_max != 0) {
           transition_ctr = 0;
           Mode = ModeInTransition;
@@ -197,356 +276,1035 @@ void NovaDotMatrix::Loop()
     }
 
 
-#ifdef NDOTM_COMPILE_DEMO
-    if (demo)
-      DemoManage();
+}
+
+#define NDOTM_DATA_DONE { \
+  /* new raw data goes straight up */ \
+  Mode           = ModeNorm; \
+  buf_contents   = NDOTM_BUF_CONTENTS_BINARY; \
+  pin_end_is_top = true;  /* so transmitted LSB is bottom row */ \
+}
+
+void NovaDotMatrix::IdleManage() {
+  //
+  // if they stop send us stuff mid byte, reset our state
+  //
+  DISABLE_INDATA_IRUPS;
+#ifdef NDOTM_RX_USI
+  // no interrupt per edge, so watch the USI counter move instead
+  uint8_t usi_cnt = USISR & 0b00001111;
+  if (usi_cnt != indata_cur_bit) {
+    indata_cur_bit  = usi_cnt;
+    indata_idle_ctr = 0;
+  }
+  if (indata_idle_ctr == indata_idle_max - 1 && usi_cnt) {
+    // stuck part way through a byte. start over
+    USISR          = _BV(USIOIF);
+    indata_cur_bit = 0;
+  }
+#else
+  if (indata_idle_ctr == indata_idle_max - 1) {
+    // if idle for a while, reset state
+    indata_cur_bit = 7;
+    indata_raw     = 0; // don't let a broken byte's bits leak into the next
+  }
 #endif
 
+  if (indata_idle_ctr < indata_idle_max)
+    ++indata_idle_ctr;
+  ENABLE_INDATA_IRUPS;
 
+  if (indata_state >= indata_state_pkt_hunt ||
+      (indata_state == indata_state_rx_params && (cmd.len & NDOTM_CMD_RAW))) {
+    // a packet that stalls part way through is dropped,
+    // and a quiet line ends the hunt for the next one.
+    // raw params can't see an escape, so they time out too
+    if (++pkt_idle_ctr > NDOTM_PKT_IDLE_MAX)
+      indata_state = indata_state_norm;
+  }
 }
 
 void NovaDotMatrix::ProcessInData() {
   //
   // Check for incoming data and process it
   //
-  static bool last_char_was_esc            = false;
-  static uint8_t last_cmd;
-  static uint8_t ctr = 0;
+  NDOTM_PROFILE_SITE(ndotm_prof_process_in_data);
   uint8_t c;
 
-#if 1 
-  //
-  // if they stop send us stuff mid byte, reset our state
-  //
+  // another 8 bits arrived. Do something with it
   DISABLE_INDATA_IRUPS;
-  //if (attinytimer.FastFlags & indata_fast_ctr_flag_bit) {
-  if (ATtinyTimerFastFlags & indata_fast_ctr_flag_bit) {
-    ATtinyTimerFastFlags &= ~indata_fast_ctr_flag_bit;
+  if (indata_available) {
+    c                = indata; // get collected bits
+    indata           = 0; // clear collection area so more can get or'd in
+    indata_available = false;  // trigger to ISR to fetch more
+#ifdef NDOTM_READY_LINE
+    NDOTM_READY; // room for one more while we chew on this one
+#endif
     ENABLE_INDATA_IRUPS;
 
+    pkt_idle_ctr = 0;
+    RxByte(c);
+  } // if (indata_available) 
+  ENABLE_INDATA_IRUPS;
+}
+
+void NovaDotMatrix::RxByte(uint8_t c) {
+  //
+  // one byte from the master
+  //
+  switch(indata_state) {
+    // packets are length counted, so escapes mean nothing inside them
+    case indata_state_rx_packet_len:
+      pkt_len      = c;
+      pkt_ctr      = 0;
+      pkt_crc      = ndotm_crc8(0, c);
+      indata_state = pkt_len ? indata_state_rx_packet_body : indata_state_rx_packet_crc;
+      return;
+
+    case indata_state_rx_packet_body:
+      if (pkt_ctr < NDOTM_PKT_MAXLEN)
+        pkt_buf[pkt_ctr] = c;
+      pkt_crc = ndotm_crc8(pkt_crc, c);
+      if (++pkt_ctr >= pkt_len)
+        indata_state = indata_state_rx_packet_crc;
+      return;
+
+    case indata_state_rx_packet_crc:
+      if (c == pkt_crc && pkt_len <= NDOTM_PKT_MAXLEN) {
+        indata_state = indata_state_norm;
+        DispatchPacket();
+      } else {
+        // bad packet. we can't trust anything until the next one starts
+        indata_state = indata_state_pkt_hunt;
+      }
+      last_char_was_esc = false;
+      return;
+
+    case indata_state_rx_params:
+      if (cmd.len & NDOTM_CMD_RAW) {
+        // taken as is, so even the escape code can be shown
+        RxParam(c);
+        return;
+      }
+      break;
+
+    case indata_state_rx_canvas:
+      // we know how many are coming, so they are taken as is
+      RxParam(c);
+      return;
 
-    if (indata_idle_ctr == indata_idle_max - 1) {
-      // if idle for a while, reset state
-      novadotmatrix.indata_cur_bit = 7;
+    case indata_state_pkt_hunt:
+      // throw everything away until <esc> ndotm_cmd_packet or ndotm_cmd_reset
+      if (last_char_was_esc && (c == ndotm_cmd_packet || c == ndotm_cmd_reset)) 
+        RxCmd(c);
+      last_char_was_esc = (c == ndotm_cmd_escape_code) && !last_char_was_esc;
+      return;
+
+    default:
+      break;
+  }
+
+  if (last_char_was_esc) { 
+    // if previous character was an escape
+    RxCmd(c);
+    last_char_was_esc=false;
+  } else if (c == ndotm_cmd_escape_code) { // if <esc>
+    // got command escape. next character interpreted as command
+    last_char_was_esc = true;
+  } else // any other character besides <esc> or character following <esc> (dealt with above)
+  { 
+    RxParam(c);
+  }
+}
+
+/*
+   Commands from the master
+
+   Every command has an entry in cmd_table[], indexed by opcode, giving
+   how many parameter bytes follow it and the handler that acts on them.
+   Parameters are collected into params[] and the handler is called once
+   they have all arrived, so a new command is one table entry and one
+   handler.
+
+   NDOTM_CMD_COUNTED: high nibble of the first parameter is a count of
+                      extra parameter bytes
+   NDOTM_CMD_STRING:  followed by a null terminated string, collected into buf
+   NDOTM_CMD_RAW:     parameters are taken as is, even the escape code
+*/
+const NovaDotMatrix::cmd_entry NovaDotMatrix::cmd_table[] PROGMEM = {
+  // opcode                 parameters                  handler
+  { ndotm_cmd_reset,        0,                          &NovaDotMatrix::CmdReset      },
+  { ndotm_cmd_message,      NDOTM_CMD_STRING,           &NovaDotMatrix::CmdMessage    },
+  { ndotm_cmd_flip,         0,                          &NovaDotMatrix::CmdFlip       },
+  { ndotm_cmd_noflip,       0,                          &NovaDotMatrix::CmdNoflip     },
+  { ndotm_cmd_font,         1,                          &NovaDotMatrix::CmdFont       },
+  { ndotm_cmd_dwell,        1,                          &NovaDotMatrix::CmdDwell      },
+  { ndotm_cmd_rate,         1,                          &NovaDotMatrix::CmdRate       },
+  { ndotm_cmd_transition,   1,                          &NovaDotMatrix::CmdTransition },
+  { ndotm_cmd_data,         NDOTM_NUMCOLS,              &NovaDotMatrix::CmdData       },
+  { ndotm_cmd_data_scroll,  1,                          &NovaDotMatrix::CmdDataScroll },
+  { ndotm_cmd_char,         1 | NDOTM_CMD_RAW,          &NovaDotMatrix::CmdChar       },
+  { ndotm_cmd_shift_dir,    1,                          &NovaDotMatrix::CmdShiftDir   },
+  { ndotm_cmd_2ch,          2,                          &NovaDotMatrix::Cmd2ch        },
+  { ndotm_cmd_2ch_flipped,  2,                          &NovaDotMatrix::Cmd2ch        },
+  { ndotm_cmd_col,          2,                          &NovaDotMatrix::CmdCol        },
+  { ndotm_cmd_cols,         1 | NDOTM_CMD_COUNTED,      &NovaDotMatrix::CmdCols       },
+  { ndotm_cmd_pixels,       2,                          &NovaDotMatrix::CmdPixels     },
+  { ndotm_cmd_packet,       0,                          &NovaDotMatrix::CmdPacket     },
+  { ndotm_cmd_diag,         1,                          &NovaDotMatrix::CmdDiag       },
+  { ndotm_cmd_counter,      2 | NDOTM_CMD_RAW,          &NovaDotMatrix::CmdCounter    },
+  { ndotm_cmd_count_up,     0,                          &NovaDotMatrix::CmdCountUp    },
+  { ndotm_cmd_count_down,   0,                          &NovaDotMatrix::CmdCountDown  },
+  { ndotm_cmd_count_add,    1 | NDOTM_CMD_RAW,          &NovaDotMatrix::CmdCountAdd   },
+  { ndotm_cmd_playlist_store, 4 | NDOTM_CMD_RAW | NDOTM_CMD_STRING, &NovaDotMatrix::CmdPlaylistStore },
+  { ndotm_cmd_playlist,     2,                          &NovaDotMatrix::CmdPlaylist   },
+  { ndotm_cmd_glyph,        6 | NDOTM_CMD_RAW,          &NovaDotMatrix::CmdGlyph      },
+  { ndotm_cmd_canvas,       2 | NDOTM_CMD_RAW,          &NovaDotMatrix::CmdCanvas     },
+  { ndotm_cmd_view,         2 | NDOTM_CMD_RAW,          &NovaDotMatrix::CmdView       },
+  { ndotm_cmd_pan,          2 | NDOTM_CMD_RAW,          &NovaDotMatrix::CmdPan        },
+  { ndotm_cmd_drift,        2 | NDOTM_CMD_RAW,          &NovaDotMatrix::CmdDrift      },
+  { ndotm_cmd_scroll_dir,   1,                          &NovaDotMatrix::CmdScrollDir  },
+  { ndotm_cmd_transition_fx, 2,                         &NovaDotMatrix::CmdTransitionFx },
+  { ndotm_cmd_effect,       2 | NDOTM_CMD_RAW,          &NovaDotMatrix::CmdEffect     },
+};
+
+void NovaDotMatrix::RxCmd(uint8_t c) {
+  //
+  // c followed an escape (or started a command in a packet)
+  //
+  indata_state = indata_state_norm;
+  last_cmd     = c;
+
+  if (!c || c >= ndotm_cmd_max)
+    return; // not a command we know
+
+  memcpy_P(&cmd, &cmd_table[c - 1], sizeof(cmd));
+  if (cmd.opcode != c)
+    return; // table out of step with NovaDotMatrixCommands.h
+
+  ctr = 0;
+  if (cmd.len & NDOTM_CMD_LEN_MASK)
+    indata_state = indata_state_rx_params;
+  else if (cmd.len & NDOTM_CMD_STRING)
+    indata_state = indata_state_rx_string;
+  else
+    (this->*cmd.handler)();
+}
+
+void NovaDotMatrix::RxParam(uint8_t c) {
+  //
+  // c is not a command, so it belongs to whatever we are in the middle of
+  //
+  switch(indata_state) {
+    case indata_state_norm:
+      // by default, we just prepare to display the character
+      params[0] = c;
+      CmdChar();
+      break;
+
+    case indata_state_rx_params:
+      if (ctr < NDOTM_MAX_PARAMS)
+        params[ctr] = c;
+      ctr++;
+
+      if (ctr == 1 && (cmd.len & NDOTM_CMD_COUNTED)) {
+        uint8_t extra = c >> 4;
+        if (extra >= NDOTM_MAX_PARAMS)
+          extra = NDOTM_MAX_PARAMS - 1;
+        cmd.len += extra;
+      }
+
+      if (ctr < (cmd.len & NDOTM_CMD_LEN_MASK))
+        break;
+
+      if (cmd.len & NDOTM_CMD_STRING) {
+        ctr          = 0;
+        indata_state = indata_state_rx_string;
+        break;
+      }
+      indata_state = indata_state_norm;
+      (this->*cmd.handler)();
+      break;
+
+    case indata_state_rx_string:
+      if (!Utf8(c))
+        break;
+      if (c) {
+        // past NDOTM_MSGLEN, dropped up to the 0 so none of it shows as characters
+        if (ctr < NDOTM_MSGLEN)
+          buf[ctr++] = c;
+        break;
+      }
+
+      buf[ctr]     = 0;
+      indata_state = indata_state_norm;
+      (this->*cmd.handler)();
+      break;
+
+    case indata_state_rx_canvas:
+      buf[canvas_ctr++] = c;
+      if (canvas_ctr >= canvas_w)
+        indata_state = indata_state_norm;
+      break;
+
+    default:
+      break;
+  }
+}
+
+bool NovaDotMatrix::Utf8(uint8_t &c) {
+  //
+  // fold UTF-8 down to Latin-1 a byte at a time. false while we're
+  // part way through a character
+  //
+  if (utf8_left) {
+    if ((c & 0b11000000) == 0b10000000) {
+      if (--utf8_left)
+        return false;
+      if (utf8_lead == 0xc2 || utf8_lead == 0xc3)
+        c = ((utf8_lead & 0b00000011) << 6) | (c & 0b00111111);
+      else
+        c = NDOTM_CHAR_REPLACEMENT; // past Latin-1, or not proper UTF-8
+      return true;
     }
+    utf8_left = 0; // broken off. forget it and take c as it is
+  }
 
-    if (indata_idle_ctr < indata_idle_max)
-      ++indata_idle_ctr;
+  if (c >= 0xc0 && c <= 0xf7) {
+    utf8_lead = c;
+    utf8_left = (c < 0xe0) ? 1 : (c < 0xf0) ? 2 : 3;
+    return false;
+  }
+  return true;
+}
 
+void NovaDotMatrix::CmdReset(void) {
+  // Got the command to reset.. reset everything
+  pin_end_is_top  = false;
+  flip2char       = false;
+  dwell_div       = dwell_ctr             = NDOTM_DWELL_VAL;
+  scroll_rate_div = scroll_rate_ctr       = NDOTM_SCROLLRATE_VAL;
+  transition_ctr  = 0;
+  transition_max  = NDOTM_TRANSITION_MAX;
+#ifdef NDOTM_TRANSITION_FX
+  transition_fx   = ndotm_fx_cut;
+#endif
+  scrollstep      = 0;
+  cur_font        = cur_font_5x7;
+  txt_headp       = txt_curp              = (char *)buf;
+  shift_dir       = 0;
+  scroll_dir      = ndotm_scroll_left;
+  effect          = ndotm_effect_off;
+  playlist_count  = 0;
+
+  // display a blank
+  for(uint8_t i = 0; i < NDOTM_NUMCOLS; i++) {
+    buf[i] = 0b00000000;
   }
-  ENABLE_INDATA_IRUPS;
+  buf_contents = NDOTM_BUF_CONTENTS_BINARY;
+}
+
+void NovaDotMatrix::CmdMessage(void) {
+  // message is already in buf
+  playlist_count = 0; // and it replaces any playlist
+  txt_headp = txt_curp = (char *)buf;
+  buf_contents = NDOTM_BUF_CONTENTS_ASCII;
+  Mode = ModeStartScrollMessage;
+}
+
+void NovaDotMatrix::CmdFlip(void) {
+  // set display upside down
+  pin_end_is_top = true;
+}
+
+void NovaDotMatrix::CmdNoflip(void) {
+  // set display right side up
+  pin_end_is_top = false;
+}
+
+void NovaDotMatrix::CmdFont(void) {
+  if (params[0] == 0)
+    cur_font = cur_font_5x7;
+  else
+    cur_font = cur_font_3x5;
+  Mode = ModeStartTransition;
+}
+
+void NovaDotMatrix::CmdDwell(void) {
+  dwell_div = dwell_ctr = params[0];
+  Mode = ModeStartTransition;
+}
+
+void NovaDotMatrix::CmdRate(void) {
+  scroll_rate_div = scroll_rate_ctr = params[0];
+  Mode = ModeStartTransition;
+}
+
+void NovaDotMatrix::CmdTransition(void) {
+  transition_ctr = transition_max = params[0];
+  Mode = ModeStartTransition;
+}
 
+void NovaDotMatrix::CmdTransitionFx(void) {
+  // effect, scroll ticks a step
+#ifdef NDOTM_TRANSITION_FX
+  transition_fx = (params[0] <= ndotm_fx_push_down) ? params[0] : (uint8_t)ndotm_fx_cut;
+  fx_div        = params[1] ? params[1] : 1;
 #endif
+  Mode = ModeStartTransition; // never carry on one already part way with the new effect
+}
 
-  // another 8 bits arrived. Do something with it
-  DISABLE_INDATA_IRUPS;
-  if (indata_available) {
-    c                = indata; // get collected bits
-    indata           = 0; // clear collection area so more can get or'd in
-    indata_available = false;  // trigger to ISR to fetch more
-    ENABLE_INDATA_IRUPS;
+void NovaDotMatrix::CmdShiftDir(void) {
+  shift_dir = params[0];
+  Mode = ModeStartTransition;
+}
 
-    if (last_char_was_esc) { 
-      // if previous character was an escape
-      switch(c) {
-        // what's character following the escape ?
-        case  ndotm_cmd_reset: 
-          // Got the command to reset.. reset everything
-          pin_end_is_top  = false;
-          flip2char       = false;
-          dwell_div       = dwell_ctr             = NDOTM_DWELL_VAL;
-          scroll_rate_div = scroll_rate_ctr       = NDOTM_SCROLLRATE_VAL;
-          transition_ctr  = 0;
-          transition_max  = NDOTM_TRANSITION_MAX;
-          scrollstep      = 0;
-          cur_font        = cur_font_5x7;
-          txt_headp       = txt_curp              = (char *)buf;
-          shift_dir       = 0;
-
-          // display a blank
-          for(ctr = 0; ctr < NDOTM_NUMCOLS; ctr++) {
-            buf[ctr] = 0b00000000;
-          }
-          buf_contents = NDOTM_BUF_CONTENTS_BINARY;
-          indata_state = indata_state_norm;
-          break; 
-
-
-
-        case  ndotm_cmd_flip: // set display upside down
-          pin_end_is_top = true;
-          break;
-
-        case  ndotm_cmd_noflip: // set display upside down
-          pin_end_is_top = false;
-          break;
-
-        case  ndotm_cmd_dwell: // set dwell 
-          indata_state = indata_state_rx_single_cmd_opcode;
-          break;
-
-        case  ndotm_cmd_transition: // set transition
-          indata_state = indata_state_rx_single_cmd_opcode;
-          break;
-
-        case  ndotm_cmd_rate: // set scroll rate
-          indata_state = indata_state_rx_single_cmd_opcode;
-          break;
-
-        case  ndotm_cmd_font: // set scroll rate
-          indata_state = indata_state_rx_single_cmd_opcode;
-          break;
-
-        case  ndotm_cmd_shift_dir: // shift display  
-          indata_state = indata_state_rx_single_cmd_opcode;
-          break;
-
-        case  ndotm_cmd_2ch: // 2 little characters
-        case  ndotm_cmd_2ch_flipped: // 2 little characters 
-          indata_state = indata_state_rx_double_cmd_opcode;
-          ctr = 0;
-          break;
-
-        case  ndotm_cmd_message: 
-          indata_state = indata_state_rx_message;
-          ctr = 0;
-          break;
-
-        case ndotm_cmd_data:
-          // the next 5 bytes will be display data
-          indata_state = indata_state_rx_data;
-          ctr = 0;
-          break;
-
-        case ndotm_cmd_data_scroll:
-          // accept one byte which is a new column of data
-          indata_state = indata_state_rx_data_single_byte_for_scroll;
-          ctr = 0;
-          break;
-
-        case ndotm_cmd_char:
-          break;
-
-        default:
-          break;
+void NovaDotMatrix::CmdScrollDir(void) {
+  if (params[0] <= ndotm_scroll_down)
+    scroll_dir = params[0];
+  if (Mode == ModeScrollMessage)
+    Mode = ModeStartScrollMessage; // start the message over the new way
+}
 
-      }
-      last_char_was_esc=false;
-      last_cmd = c;
-    } else if (c == ndotm_cmd_escape_code) { // if <esc>
-      // got command escape. next character interpreted as command
-      last_char_was_esc = true;
-    } else // any other character besides <esc> or character following <esc> (dealt with above)
-    { 
-      switch(indata_state) {
-        // what to do with next byte
-        case indata_state_norm:
-          // by default, we just prepare to display the character
-          buf[0] = c; // get ascii character.. 
-          buf[1] = 0;
-          Mode = ModeStartTransition;
-          buf_contents = NDOTM_BUF_CONTENTS_ASCII;
-          //pin_end_is_top = false; // so transmitted LSB is bottom row
-          break;
-
-        case indata_state_rx_message:
-          // receive 5 bytes of raw data for display
-          if (ctr < 32)
-            buf[ctr] = c;
-
-          if (ctr >= 32 || c == 0) {
-            buf[ctr] = c;
-            buf[ctr+1] = 0;
-
-            txt_headp = txt_curp = (char *)buf;
-            buf_contents = NDOTM_BUF_CONTENTS_ASCII;
-
-            indata_state = indata_state_norm;
-            Mode = ModeStartScrollMessage;
-          }
-          ctr++;
-          break;
-
-        case indata_state_rx_data:
-          // --
-          // receive 5 bytes of raw data for display
-          switch(ctr) {
-            case 0: // receive first byte
-            case 1: // receive next byte..
-            case 2: // and the next..
-            case 3: // and the next..
-              buf[4-ctr] = c;
-              break;
-
-            case 4: // last one
-              buf[4-ctr]         = c;
-
-              indata_state       = indata_state_norm;
-              Mode               = ModeNorm;
-              buf_contents = NDOTM_BUF_CONTENTS_BINARY;
-              pin_end_is_top     = true;              // so transmitted LSB is bottom row
-
-              break;
-
-            default:
-              break;
-          } 
-          if (ctr < NDOTM_NUMCOLS) ctr++;
-          break;
-          // --
-
-
-        case indata_state_rx_data_single_byte_for_scroll:
-          switch(shift_dir) {
-            case 0:
-              // shift r->l
-              buf[4] = buf[3];
-              buf[3] = buf[2];
-              buf[2] = buf[1];
-              buf[1] = buf[0];
-              buf[0] = c;
-              break;
-
-            case 1:
-              // shift r->l
-              buf[0] = buf[1];
-              buf[1] = buf[2];
-              buf[2] = buf[3];
-              buf[3] = buf[4];
-              buf[4] = c;
-              break;
-
-            case 2:
-            /*
-             *            source                 dest
-             *           coldata[]              coldata[]
-             *   bitpos  v v v v v      bitpos  v v v v v
-             *       v  |0|1|2|3|4|         v  |0|1|2|3|4|
-             *      [0]:|a|b|c|d|e|        [0]:|A|B|C|D|E|
-             *      [1]:|f|g|h|i|j|        [1]:|a|b|c|d|e|
-             *      [2]:| | | | | |  --->  [2]:|f|g|h|i|j|
-             *      [3]:| | | | | |        [3]:| | | | | |
-             *      [4]:| | | | | |        [4]:| | | | | |
-             *      [5]:| | | | | |        [5]:| | | | | |
-             *      [6]:| | | | | |        [6]:| | | | | |
-             *          +++++++++++            ++-+-+-+-++
-             *           | | | | |              | | | | |
-             *         edge connector         edge connector
-             */
-
-            for (uint8_t i = 0; i < NDOTM_NUMCOLS; i++) {
-              buf[i] = buf[i] >> 1;
-              buf[i] |= c & (1 << i) ? 0b01000000 : 0;
-            }
+void NovaDotMatrix::CmdChar(void) {
+  // display one character
+  buf[0] = params[0]; // get ascii character.. 
+  buf[1] = 0;
+  Mode = ModeStartTransition;
+  buf_contents = NDOTM_BUF_CONTENTS_ASCII;
+  //pin_end_is_top = false; // so transmitted LSB is bottom row
+}
 
-              break;
+void NovaDotMatrix::Cmd2ch(void) {
+  // 2 little characters
+  buf[0] = params[0];
+  buf[1] = params[1];
+  buf[2] = 0;
+  cur_font     = cur_font_3x5;
+  buf_contents = NDOTM_BUF_CONTENTS_2ASCII;
+  Mode         = ModeStartTransition;
+  if (last_cmd == ndotm_cmd_2ch_flipped)
+    flip2char    = true;
+}
 
-            case 3:
-            for (uint8_t i = 0; i < NDOTM_NUMCOLS; i++) {
-              buf[i] = buf[i] << 1;
-              buf[i] |= c & (1 << i) ? 0b00000001 : 0;
-            }
+void NovaDotMatrix::CmdCounter(void) {
+  // flags, then the value to start from
+  counter_flags = params[0];
+  counter_val   = params[1];
+  CounterShow(0);
+}
 
+void NovaDotMatrix::CmdCountUp(void) {
+  CounterShow(1);
+}
 
-              break;
-
-          }
-
-          indata_state   = indata_state_norm;
-          Mode           = ModeNorm;
-          buf_contents   = NDOTM_BUF_CONTENTS_BINARY;
-          pin_end_is_top = true;                      // so transmitted LSB is bottom row
-          break;
-
-        case indata_state_rx_single_cmd_opcode:
-          // get paramater byte that follows command opcode 
-          switch(last_cmd) {
-            case ndotm_cmd_transition:
-              transition_ctr = transition_max = c;
-              break;
-            case ndotm_cmd_dwell:
-              dwell_div = dwell_ctr = c;
-              break;
-            case ndotm_cmd_rate:
-              scroll_rate_div = scroll_rate_ctr = c;
-              break;
-            case ndotm_cmd_font:
-              if (c == 0)
-                cur_font = cur_font_5x7;
-              else
-                cur_font = cur_font_3x5;
-              break;
-            case ndotm_cmd_shift_dir:
-              shift_dir = c;
-              break;
-            default:
-              break;
-          }
-          Mode         = ModeStartTransition;
-          indata_state = indata_state_norm;
-          break;
-
-        case indata_state_rx_double_cmd_opcode:
-          buf[ctr] = c;
-
-          //NDOTM_BLIP_ON_SCOPE(10);
-
-          if (++ctr > 1) {
-            buf[ctr] = 0;
-            // got both. we are done.
-            cur_font     = cur_font_3x5;
-            buf_contents = NDOTM_BUF_CONTENTS_2ASCII;
-            Mode         = ModeStartTransition;
-            indata_state = indata_state_norm;
-            if (last_cmd == ndotm_cmd_2ch_flipped)
-              flip2char    = true;
-
-          }
-          break;
-
-
-        default:
-          break;
+void NovaDotMatrix::CmdCountDown(void) {
+  CounterShow(-1);
+}
 
+void NovaDotMatrix::CmdCountAdd(void) {
+  CounterShow((int8_t)params[0]);
+}
 
-      }
+void NovaDotMatrix::CounterShow(int8_t delta) {
+  // move the counter along and draw it like ndotm_cmd_char or ndotm_cmd_2ch
+  uint8_t range = (counter_flags & ndotm_counter_big) ? 10 : 100;
+  int16_t v     = counter_val + delta;
+
+  if (counter_flags & ndotm_counter_wrap) {
+    v %= range;
+    if (v < 0)
+      v += range;
+  } else if (v < 0) {
+    v = 0;
+  } else if (v >= range) {
+    v = range - 1;
+  }
+  counter_val = v;
+
+  if (counter_flags & ndotm_counter_big) {
+    buf[0]       = '0' + counter_val;
+    buf[1]       = 0;
+    cur_font     = cur_font_5x7;
+    buf_contents = NDOTM_BUF_CONTENTS_ASCII;
+  } else {
+    buf[0]       = '0' + counter_val / 10;
+    if (counter_val < 10 && (counter_flags & ndotm_counter_blank0))
+      buf[0]     = ' ';
+    buf[1]       = '0' + counter_val % 10;
+    buf[2]       = 0;
+    cur_font     = cur_font_3x5;
+    buf_contents = NDOTM_BUF_CONTENTS_2ASCII;
+    flip2char    = counter_flags & ndotm_counter_flipped;
+  }
+  Mode = ModeStartTransition;
+}
+
+void NovaDotMatrix::CmdPlaylistStore(void) {
+  // slot, dwell, rate, flags, and the message is in buf
+  uint8_t *e;
+  uint8_t i;
+
+  if (params[0] >= NDOTM_PLAYLIST_SLOTS)
+    return;
+
+  e = (uint8_t *)(NDOTM_PLAYLIST_EEPROM + params[0] * NDOTM_PLAYLIST_SLOT_LEN);
+  eeprom_update_byte(e++, params[1]);
+  eeprom_update_byte(e++, params[2]);
+  eeprom_update_byte(e++, params[3]);
+  for (i = 0; i < NDOTM_MSGLEN && buf[i]; i++)
+    eeprom_update_byte(e++, buf[i]);
+  eeprom_update_byte(e, 0);
+
+  // show it while we're at it
+  txt_headp = txt_curp = (char *)buf;
+  buf_contents = NDOTM_BUF_CONTENTS_ASCII;
+  Mode = ModeStartScrollMessage;
+}
+
+void NovaDotMatrix::CmdPlaylist(void) {
+  // first slot, how many
+  playlist_first = params[0];
+  playlist_count = params[1];
+  if (playlist_first >= NDOTM_PLAYLIST_SLOTS)
+    playlist_count = 0;
+  if (playlist_first + playlist_count > NDOTM_PLAYLIST_SLOTS)
+    playlist_count = NDOTM_PLAYLIST_SLOTS - playlist_first;
+  if (!playlist_count)
+    return;
+
+  playlist_cur = playlist_count - 1; // so the next one is the first
+  PlaylistNext();
+  if (playlist_count)
+    Mode = ModeStartScrollMessage;
+}
+
+void NovaDotMatrix::PlaylistNext(void) {
+  //
+  // load the next stored message that isn't empty, with its settings
+  //
+  uint8_t *e;
+  uint8_t i, c, flags;
+
+  for (i = 0; i < playlist_count; i++) {
+    if (++playlist_cur >= playlist_count)
+      playlist_cur = 0;
+    e = (uint8_t *)(NDOTM_PLAYLIST_EEPROM + 
+        (playlist_first + playlist_cur) * NDOTM_PLAYLIST_SLOT_LEN);
+    c = eeprom_read_byte(e + 3);
+    if (c && c != 0xff) // never written, or written empty
+      break;
+  }
+  if (i == playlist_count) {
+    playlist_count = 0; // nothing to play
+    return;
+  }
+
+  dwell_div       = dwell_ctr       = eeprom_read_byte(e++);
+  scroll_rate_div = scroll_rate_ctr = eeprom_read_byte(e++);
+  flags           = eeprom_read_byte(e++);
+  cur_font        = (flags & ndotm_playlist_3x5) ? cur_font_3x5 : cur_font_5x7;
+  pin_end_is_top  = flags & ndotm_playlist_flip;
+
+  for (i = 0; i < NDOTM_MSGLEN; i++) {
+    buf[i] = eeprom_read_byte(e++);
+    if (!buf[i])
+      break;
+  }
+  buf[i] = 0;
+
+  txt_headp = txt_curp = (char *)buf;
+  buf_contents = NDOTM_BUF_CONTENTS_ASCII;
+}
+
+void NovaDotMatrix::CmdGlyph(void) {
+  // character code, then 5 columns
+  uint8_t g = params[0] - NDOTM_GLYPH_FIRST;
+  uint8_t *e;
+
+  if (g >= NDOTM_GLYPHS)
+    return;
+
+  e = (uint8_t *)(NDOTM_GLYPH_EEPROM + g * NDOTM_GLYPH_LEN);
+  for (uint8_t i = 0; i < NDOTM_GLYPH_LEN; i++)
+    eeprom_update_byte(e++, params[1 + i]);
+}
+
+void NovaDotMatrix::CmdCanvas(void) {
+  // canvas width, first column to load, then the columns
+  if (!params[0] || params[0] > NDOTM_CANVAS_MAXW || params[1] >= params[0])
+    return;
+
+  canvas_w   = params[0];
+  canvas_ctr = params[1];
+  if (!canvas_ctr) {
+    // a new picture. start at its top left, standing still
+    view_x  = view_y  = 0;
+    drift_x = drift_y = 0;
+  }
+
+  NDOTM_DATA_DONE;
+  buf_contents = NDOTM_BUF_CONTENTS_CANVAS;
+  indata_state = indata_state_rx_canvas;
+}
+
+void NovaDotMatrix::CmdView(void) {
+  // put the view at column, row
+  if (buf_contents != NDOTM_BUF_CONTENTS_CANVAS)
+    return;
+  view_x = view_y = 0;
+  CanvasPan(params[0] % canvas_w, params[1] % NDOTM_NUMROWS);
+}
+
+void NovaDotMatrix::CmdPan(void) {
+  // move the view by signed columns, rows
+  if (buf_contents == NDOTM_BUF_CONTENTS_CANVAS)
+    CanvasPan(params[0], params[1]);
+}
+
+void NovaDotMatrix::CmdDrift(void) {
+  // move the view by signed columns, rows every scroll step. 0, 0 stops
+  drift_x = params[0];
+  drift_y = params[1];
+}
+
+void NovaDotMatrix::CanvasPan(int8_t dx, int8_t dy) {
+  // move the view, wrapping round the edges of the canvas
+  int16_t x = view_x + dx;
+  int8_t  y = view_y + dy;
+
+  while (x < 0)
+    x += canvas_w;
+  while (x >= canvas_w)
+    x -= canvas_w;
+  while (y < 0)
+    y += NDOTM_NUMROWS;
+  while (y >= NDOTM_NUMROWS)
+    y -= NDOTM_NUMROWS;
+
+  view_x = x;
+  view_y = y;
+}
+
+uint8_t NovaDotMatrix::CanvasCol(uint8_t i) {
+  //
+  // what coldata[i] shows of the canvas. nothing is moved to pan, we just
+  // look somewhere else
+  //
+  uint8_t x = view_x + NDOTM_LASTCOL - i; // coldata[] runs right to left
+  uint8_t c;
+
+  while (x >= canvas_w)
+    x -= canvas_w;
+  c = buf[x];
+
+  if (view_y) // canvas row view_y to the top, rows above it round the bottom
+    c = ((c << view_y) | (c >> (NDOTM_NUMROWS - view_y))) & NDOTM_ALLROWS;
+  return c;
+}
+
+void NovaDotMatrix::CmdData(void) {
+  // a byte of raw data per column, sent last column first
+  for (uint8_t i = 0; i < NDOTM_NUMCOLS; i++)
+    buf[NDOTM_LASTCOL-i] = params[i];
+
+  NDOTM_DATA_DONE;
+#ifdef NDOTM_TRANSITION_FX
+  if (transition_fx != ndotm_fx_cut)
+    Mode = ModeStartTransition; // a whole new frame. ease it in
+#endif
+}
+
+void NovaDotMatrix::CmdDataScroll(void) {
+  // one byte which is a new column of data
+  uint8_t c = params[0];
+
+  switch(shift_dir) {
+    case 0:
+      // shift r->l
+      for (uint8_t i = NDOTM_LASTCOL; i > 0; i--)
+        buf[i] = buf[i - 1];
+      buf[0] = c;
+      break;
+
+    case 1:
+      // shift l->r
+      for (uint8_t i = 0; i < NDOTM_LASTCOL; i++)
+        buf[i] = buf[i + 1];
+      buf[NDOTM_LASTCOL] = c;
+      break;
+
+    case 2:
+    /*
+     *            source                 dest
+     *           coldata[]              coldata[]
+     *   bitpos  v v v v v      bitpos  v v v v v
+     *       v  |0|1|2|3|4|         v  |0|1|2|3|4|
+     *      [0]:|a|b|c|d|e|        [0]:|A|B|C|D|E|
+     *      [1]:|f|g|h|i|j|        [1]:|a|b|c|d|e|
+     *      [2]:| | | | | |  --->  [2]:|f|g|h|i|j|
+     *      [3]:| | | | | |        [3]:| | | | | |
+     *      [4]:| | | | | |        [4]:| | | | | |
+     *      [5]:| | | | | |        [5]:| | | | | |
+     *      [6]:| | | | | |        [6]:| | | | | |
+     *          +++++++++++            ++-+-+-+-++
+     *           | | | | |              | | | | |
+     *         edge connector         edge connector
+     */
 
+    for (uint8_t i = 0; i < NDOTM_NUMCOLS; i++) {
+      buf[i] = buf[i] >> 1;
+      buf[i] |= c & (1 << i) ? NDOTM_TOPROW_BIT : 0;
     }
-  } // if (indata_available) 
-  ENABLE_INDATA_IRUPS;
+
+      break;
+
+    case 3:
+    for (uint8_t i = 0; i < NDOTM_NUMCOLS; i++) {
+      buf[i] = (buf[i] << 1) & NDOTM_ALLROWS;
+      buf[i] |= c & (1 << i) ? 0b00000001 : 0;
+    }
+
+
+      break;
+
+  }
+
+  NDOTM_DATA_DONE;
 }
 
-void inline NovaDotMatrix::CommonLoopChores() {
-  // most of the common work done no matter what state we are in...
-  if (!ATtinyTimerFiveHundredHzCtr)  {
-    WriteNextCol(); // Most of the work is done in WriteNextCol()
-
-    if (col_num_leds_on <= 3)
-      // bit of a brightness leveling hack..
-      // mitigate uneven brightness issues...
-      // don't leave on as long since fewer leds are on..
-      // otherwise they'll appear brighter due to current suck.
-      // TODO: This can be obviated in the next rev of hardware by putting
-      // the series resistors in the right place
-      ATtinyTimerFiveHundredHzCtr = ATT_FIVE_HUNDRED_HZ_SHORTDIV;
+void NovaDotMatrix::CmdCol(void) {
+  // column number then one byte of column data
+  if (params[0] < NDOTM_NUMCOLS)
+    buf[NDOTM_LASTCOL-params[0]] = params[1]; // same column order as ndotm_cmd_data
+
+  NDOTM_DATA_DONE;
+}
+
+void NovaDotMatrix::CmdCols(void) {
+  // (count << 4) | first column, then count bytes of column data
+  uint8_t col = params[0] & 0b00001111;
+
+  for (uint8_t i = 1; i <= (params[0] >> 4) && i < NDOTM_MAX_PARAMS; i++, col++) {
+    if (col < NDOTM_NUMCOLS)
+      buf[NDOTM_LASTCOL-col] = params[i];
+  }
+
+  NDOTM_DATA_DONE;
+}
+
+void NovaDotMatrix::CmdPixels(void) {
+  // op | column mask, then row mask. the mask only reaches the first columns
+  for (uint8_t i = 0; i < NDOTM_PIX_COLS; i++) {
+    if (!(params[0] & (1 << i)))
+      continue;
+    switch(params[0] & NDOTM_PIX_OP_MASK) {
+      case ndotm_pix_set:
+        buf[NDOTM_LASTCOL-i] |= params[1];
+        break;
+      case ndotm_pix_clear:
+        buf[NDOTM_LASTCOL-i] &= ~params[1];
+        break;
+      case ndotm_pix_toggle:
+        buf[NDOTM_LASTCOL-i] ^= params[1];
+        break;
+      default:
+        break;
+    }
+  }
+
+  NDOTM_DATA_DONE;
+}
+
+void NovaDotMatrix::CmdPacket(void) {
+  // length, commands, crc. see NovaDotMatrixCommands.h
+  indata_state = indata_state_rx_packet_len;
+}
+
+void NovaDotMatrix::CmdDiag(void) {
+  // send diagnostics back to the master. see NovaDotMatrixCommands.h
+  uint8_t what = params[0] & NDOTM_DIAG_WHAT_MASK;
+
+  // park the line high (display dark) so they can find the first start bit
+  PORTB |= NDOTM_DAT_OUT_BIT;
+  delayMicroseconds(NDOTM_DIAG_PREAMBLE_BITS * NDOTM_DIAG_BIT_US);
+
+  switch(what) {
+    case ndotm_diag_timer:
+      DiagWrite(ndotm_diag_timer);
+      DiagWrite(attinytimer.MaxBacklog);
+      DiagWrite(attinytimer.LagTicks & 0xff);
+      DiagWrite(attinytimer.LagTicks >> 8);
+      DiagWrite(attinytimer.LostTicks);
+      if (params[0] & NDOTM_DIAG_CLEAR)
+        attinytimer.ClearStats();
+      break;
+
+    case ndotm_diag_profile:
+      DiagWrite(ndotm_diag_profile);
+#ifdef NDOTM_PROFILE
+      DiagWrite(ndotm_prof_max);
+      DiagWrite(TCCR0B & 0b00000111); // Timer0 clock select, so they know how long a count is
+      for (uint8_t i = 0; i < ndotm_prof_max; i++) {
+        uint8_t *p = (uint8_t *)&ndotm_prof[i];
+        for (uint8_t j = 0; j < NDOTM_DIAG_PROFILE_SITE_LEN; j++)
+          DiagWrite(*p++); // little endian, same as the wire format
+      }
+      if (params[0] & NDOTM_DIAG_CLEAR)
+        NdotmProfClear();
+#else
+      DiagWrite(0); // no sites
+      DiagWrite(0);
+#endif
+      break;
+
+    default:
+      break;
+  }
+}
+
+#ifdef NDOTM_PROFILE
+NdotmProfEntry ndotm_prof[ndotm_prof_max];
+
+void NdotmProfClear(void) {
+  for (uint8_t i = 0; i < ndotm_prof_max; i++) {
+    ndotm_prof[i].count = 0;
+    ndotm_prof[i].min   = 0xff;
+    ndotm_prof[i].max   = 0;
+    ndotm_prof[i].total = 0;
+  }
+}
+
+void NdotmProfRecord(uint8_t site, uint8_t start) {
+  // called on the way out of a NDOTM_PROFILE_SITE
+  uint8_t t = TCNT0 - start;
+  NdotmProfEntry *e = &ndotm_prof[site];
+
+  if (e->count != 0xffff) {
+    e->count++;
+    e->total += t;
+  }
+  if (t < e->min)
+    e->min = t;
+  if (t > e->max)
+    e->max = t;
+}
+#endif
+
+void NovaDotMatrix::DiagWrite(uint8_t c) {
+  // one byte of 8N1 async serial on the data out pin, lsb first
+  uint8_t sreg = SREG;
+
+  cli(); // bit timing has to hold
+  PORTB &= ~NDOTM_DAT_OUT_BIT; // start bit
+  delayMicroseconds(NDOTM_DIAG_BIT_US);
+  for (uint8_t i = 0; i < 8; i++) {
+    if (c & 0b00000001)
+      PORTB |= NDOTM_DAT_OUT_BIT;
     else
-      ATtinyTimerFiveHundredHzCtr = ATtinyTimerFiveHundredHzDiv;
+      PORTB &= ~NDOTM_DAT_OUT_BIT;
+    delayMicroseconds(NDOTM_DIAG_BIT_US);
+    c = c >> 1;
   }
+  PORTB |= NDOTM_DAT_OUT_BIT; // stop bit, and idle
+  delayMicroseconds(NDOTM_DIAG_BIT_US);
+  SREG = sreg;
 }
-uint8_t NovaDotMatrix::GetFont(uint8_t index, uint8_t offset) {
-  // get character out of font table
-  if (cur_font == cur_font_5x7) {
-    return (pgm_read_byte( (font_5x7_2 + index * 5) + offset ));
-  } else if (cur_font == cur_font_3x5) {
-    if (offset < 3)
-      return (pgm_read_byte( (font_3x5_1 + index * 3) + offset ) << 0);
+
+void NovaDotMatrix::DispatchPacket(void) {
+  //
+  // run each command in a packet that passed its crc
+  // commands are packed as <opcode> <parameters> with no escapes
+  //
+  uint8_t i = 0;
+
+  while (i < pkt_len) {
+    if (pkt_buf[i] == ndotm_cmd_packet)
+      break; // no packets in packets
+
+    RxCmd(pkt_buf[i++]);
+    while (indata_state != indata_state_norm && i < pkt_len)
+      RxParam(pkt_buf[i++]);
+  }
+  indata_state = indata_state_norm; // drop a command that was cut short
+}
+
+// shown for anything we have no picture of
+const PROGMEM uint8_t font_replacement[]     = { 0x7F, 0x41, 0x41, 0x41, 0x7F };
+const PROGMEM uint8_t font_replacement_3x5[] = { 0x1F, 0x11, 0x1F };
+
+#ifdef NDOTM_LATIN1
+static const uint8_t *Latin1Glyph(uint8_t code) {
+  // binary search font_latin1. never more than 6 looks
+  uint8_t lo = 0, hi = FONT_LATIN1_ENTRIES, mid, c;
+  const uint8_t *p;
+
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    p   = font_latin1 + mid * FONT_LATIN1_ENTRY_LEN;
+    c   = pgm_read_byte(p);
+    if (c == code)
+      return p;
+    if (c < code)
+      lo = mid + 1;
     else
+      hi = mid;
+  }
+  return 0;
+}
+#endif
+
+uint8_t NovaDotMatrix::GetFont(uint8_t index, uint8_t offset) {
+  // get character out of font table. index is the character code - 32
+  uint8_t code = index + 32;
+  uint8_t g    = code - NDOTM_GLYPH_FIRST;
+#ifdef NDOTM_LATIN1
+  const uint8_t *p;
+#endif
+
+  if (g < NDOTM_GLYPHS) {
+    // one of the ones they gave us
+    const uint8_t *e = (const uint8_t *)(NDOTM_GLYPH_EEPROM + g * NDOTM_GLYPH_LEN);
+    uint8_t col = eeprom_read_byte(e + offset);
+    if (col == 0xff) {
+      // erased eeprom reads all 0xff. never drawn, so blank, not a solid block
+      uint8_t i;
+      for (i = 0; i < NDOTM_GLYPH_LEN && eeprom_read_byte(e + i) == 0xff; i++)
+        ;
+      if (i == NDOTM_GLYPH_LEN)
+        return 0;
+    }
+    if (cur_font == cur_font_3x5)
+      return (offset < 3) ? (col & 0b00011111) : 0; // top left 3x5 of it
+    return col;
+  }
+
+  if (cur_font == cur_font_3x5) {
+    if (offset >= 3)
       return(0);
+#ifdef NDOTM_LATIN1
+    if (code >= 0x80 && (p = Latin1Glyph(code)))
+      index = pgm_read_byte(p + 1) - 32; // too small for accents. plain letter
+#endif
+    if (index < sizeof(font_3x5_1) / 3)
+      return (pgm_read_byte( (font_3x5_1 + index * 3) + offset ));
+    return (pgm_read_byte(font_replacement_3x5 + offset));
+  }
+
+  // codes under 32 wrapped round to a big index, so this catches them too
+  if (index < sizeof(font_5x7_2) / 5)
+    return (pgm_read_byte( (font_5x7_2 + index * 5) + offset ));
+#ifdef NDOTM_LATIN1
+  if ((p = Latin1Glyph(code)))
+    return (pgm_read_byte(p + 2 + offset));
+#endif
+  return (pgm_read_byte(font_replacement + offset));
+}
+
+void NovaDotMatrix::DrawFrame(void) {
+  //
+  // fill coldata[] from whatever is in buf
+  //
+  switch (buf_contents){
+    case NDOTM_BUF_CONTENTS_ASCII:
+#if NDOTM_NUMCOLS > NDOTM_GLYPH_LEN
+      memset(coldata + NDOTM_GLYPH_LEN, 0, NDOTM_NUMCOLS - NDOTM_GLYPH_LEN); // text is 5 wide. rest dark
+#endif
+      coldata[0] = GetFont(*txt_curp-32,0); // pgm_read_byte( (cur_fontp + (*txt_curp - 32) * 5) + 0 );
+      coldata[1] = GetFont(*txt_curp-32,1); 
+      coldata[2] = GetFont(*txt_curp-32,2); 
+      coldata[3] = GetFont(*txt_curp-32,3); 
+      coldata[4] = GetFont(*txt_curp-32,4); 
+      break;
+
+    case NDOTM_BUF_CONTENTS_BINARY:
+      for (uint8_t i = 0; i < NDOTM_NUMCOLS; i++)
+        coldata[i] = *(txt_curp + i);
+      break;
+
+    case NDOTM_BUF_CONTENTS_2ASCII:
+      DispTwoSmallChars(flip2char);
+      break;
+
+    case NDOTM_BUF_CONTENTS_CANVAS:
+      for (uint8_t i = 0; i < NDOTM_NUMCOLS; i++)
+        coldata[i] = CanvasCol(i);
+      break;
+
+    default:
+      break;
   }
+}
+
+#ifdef NDOTM_TRANSITION_FX
+void NovaDotMatrix::FxStart(void) {
+  //
+  // keep the frame showing now and draw the one we're going to, then 
+  // FxDraw() steps from one to the other
+  //
+  memcpy(fx_old, coldata, NDOTM_NUMCOLS);
+  txt_curp = (char *)buf;
+  DrawFrame();
+  memcpy(fx_new, coldata, NDOTM_NUMCOLS);
+  memcpy(coldata, fx_old, NDOTM_NUMCOLS);
+
+  // text scrolls toward coldata[0] whichever way up the panel is, so its
+  // effects go the way it does. data only sets pin_end_is_top so it lands
+  // the right way up, and then coldata[] runs right to left and bottom to
+  // top, as WriteCol() puts it out: swap left for right and up for down
+  fx = transition_fx;
+  if (pin_end_is_top && buf_contents >= NDOTM_BUF_CONTENTS_BINARY) {
+    if (fx >= ndotm_fx_push_left)
+      fx = ((fx - ndotm_fx_push_left) ^ 1) + ndotm_fx_push_left;
+    else if (fx < ndotm_fx_dissolve)
+      fx = ((fx - ndotm_fx_wipe_left) ^ 1) + ndotm_fx_wipe_left;
+  }
+  fx_step = fx_ctr = 0;
+}
+
+void NovaDotMatrix::FxDraw(uint8_t i) {
+  //
+  // coldata[i] for this step of the transition
+  //
+  uint8_t m, k;
+  uint16_t v;
+
+  switch (fx) {
+    case ndotm_fx_push_left:
+      // new frame comes in from the right, shoving the old one out
+      k = i + ((fx_step * NDOTM_NUMCOLS) >> 3);
+      coldata[i] = (k < NDOTM_NUMCOLS) ? fx_old[k] : fx_new[k - NDOTM_NUMCOLS];
+      break;
+
+    case ndotm_fx_push_right:
+      k = (fx_step * NDOTM_NUMCOLS) >> 3;
+      coldata[i] = (i >= k) ? fx_old[i - k] : fx_new[i + NDOTM_NUMCOLS - k];
+      break;
+
+    case ndotm_fx_push_up:
+      // the two frames stacked, lsb the top row, and a window on them
+      k = (fx_step * NDOTM_NUMROWS) >> 3;
+      v = fx_old[i] | (fx_new[i] << NDOTM_NUMROWS);
+      coldata[i] = (v >> k) & NDOTM_ALLROWS;
+      break;
+
+    case ndotm_fx_push_down:
+      k = (fx_step * NDOTM_NUMROWS) >> 3;
+      v = fx_new[i] | (fx_old[i] << NDOTM_NUMROWS);
+      coldata[i] = (v >> (NDOTM_NUMROWS - k)) & NDOTM_ALLROWS;
+      break;
 
+    default:
+      // wipes and dissolve. mask bits set show the new frame
+      m = pgm_read_byte(fx_masks + (fx - ndotm_fx_wipe_left) * NDOTM_FX_MASK_LEN + fx_step * NDOTM_NUMCOLS + i);
+      coldata[i] = (fx_old[i] & ~m) | (fx_new[i] & m);
+      break;
+  }
 }
+#endif
 
 void NovaDotMatrix::WriteNextCol() {
+  NDOTM_PROFILE_SITE(ndotm_prof_write_next_col);
   // Called during multiplexing to write out the next column of character data
   // Implements scrolling
   char *txt_nextp, space;
@@ -555,30 +1313,10 @@ void NovaDotMatrix::WriteNextCol() {
 
     case ModeNorm:
       // simple case. Just write them  w/no scrolly stuff
-      switch (buf_contents){
-        case NDOTM_BUF_CONTENTS_ASCII:
-          coldata[0] = GetFont(*txt_curp-32,0); // pgm_read_byte( (cur_fontp + (*txt_curp - 32) * 5) + 0 );
-          coldata[1] = GetFont(*txt_curp-32,1); 
-          coldata[2] = GetFont(*txt_curp-32,2); 
-          coldata[3] = GetFont(*txt_curp-32,3); 
-          coldata[4] = GetFont(*txt_curp-32,4); 
-          break;
-
-        case NDOTM_BUF_CONTENTS_BINARY:
-          coldata[0] = *(txt_curp + 0);
-          coldata[1] = *(txt_curp + 1);
-          coldata[2] = *(txt_curp + 2);
-          coldata[3] = *(txt_curp + 3);
-          coldata[4] = *(txt_curp + 4);
-          break;
-
-        case NDOTM_BUF_CONTENTS_2ASCII:
-          DispTwoSmallChars(flip2char);
-          break;
-
-        default:
-          break;
-      }
+      if (buf_contents == NDOTM_BUF_CONTENTS_CANVAS)
+        coldata[col_ctr] = CanvasCol(col_ctr); // only the one going out
+      else
+        DrawFrame();
       NDOTM_WRITE_AND_UPDATE_COL_COUNTER;
       break;
 
@@ -587,20 +1325,36 @@ void NovaDotMatrix::WriteNextCol() {
 
     case ModeInTransition:
 
+#ifdef NDOTM_TRANSITION_FX
+      if (transition_fx != ndotm_fx_cut)
+        FxDraw(col_ctr);
+      else
+#endif
       if (transition_max != 0)
         // simple case. Just write them  w/no scrolly stuff
-        coldata[0] = coldata[1] = coldata[2] = coldata[3] = coldata[4] =  0b00000000; // blank during transition
+        memset(coldata, 0, NDOTM_NUMCOLS); // blank during transition
 
       NDOTM_WRITE_AND_UPDATE_COL_COUNTER;
       break;
 
     case ModeStartScrollMessage:
-      coldata[0] = coldata[1] = coldata[2] = coldata[3] = coldata[4] =  0b00000000; 
+      memset(coldata, 0, NDOTM_NUMCOLS);
       Mode = ModeScrollMessage;
+      if (scroll_dir != ndotm_scroll_left) {
+        // up or down starts with the first character all there
+        scrollstep     = 0;
+        lastscrollstep = 0xff;
+      }
       NDOTM_WRITE_AND_UPDATE_COL_COUNTER;
       break;
 
     case ModeScrollMessage:
+      if (scroll_dir != ndotm_scroll_left) {
+        VScrollStep();
+        NDOTM_WRITE_AND_UPDATE_COL_COUNTER;
+        break;
+      }
+
       space = ' ';
       txt_nextp = txt_curp + 1;
       if (!(*txt_nextp))
@@ -684,8 +1438,11 @@ void NovaDotMatrix::WriteNextCol() {
 
             //NDOTM_BLIP_ON_SCOPE(10);
             txt_curp++;
-            if (!(*txt_curp))
+            if (!(*txt_curp)) {
               txt_curp = txt_headp;
+              if (playlist_count)
+                PlaylistNext(); // all the way through. on to the next
+            }
 
             scrollstep = 1;
             dwell_ctr = dwell_div;
@@ -709,21 +1466,62 @@ void NovaDotMatrix::WriteNextCol() {
 
 }
 
-void NovaDotMatrix::WriteCol(uint8_t colno,uint8_t rowdat) {
+void NovaDotMatrix::VScrollStep(void) {
   //
-  // load display colno with data in rowdat
+  // roll the message up or down. each character has a blank row under it,
+  // 8 rows in all, and scrollstep 0 to 7 is how many of them have gone by
   //
-  uint8_t mask,colbit;
+  char *txt_nextp, space = ' ';
+  uint16_t v;
 
-  if (pin_end_is_top) {
-    mask   = 0b00010000;
-    colbit = 0b00000001 << (4-colno);
-  } else {
+  if (lastscrollstep == scrollstep)
+    return;
 
-    mask   = 0b00001000;
-    colbit = 0b00000001 << (7-colno);
+  if (!scrollstep && lastscrollstep == 7) {
+    // the next character is all the way in. it's the current one now
+    txt_curp++;
+    if (!(*txt_curp)) {
+      txt_curp = txt_headp;
+      if (playlist_count)
+        PlaylistNext(); // all the way through. on to the next
+    }
+  }
+  lastscrollstep = scrollstep;
+
+  txt_nextp = txt_curp + 1;
+  if (!(*txt_nextp))
+    txt_nextp = &space;
+
+  // lsb is the top row, so the two characters stacked are one 16 bit 
+  // column, and the display is a 7 row window on it
+  for (uint8_t i = 0; i < NDOTM_GLYPH_LEN; i++) {
+    if (scroll_dir == ndotm_scroll_up) {
+      v = GetFont(*txt_curp - 32, i) | (GetFont(*txt_nextp - 32, i) << 8);
+      coldata[i] = (v >> scrollstep) & NDOTM_ALLROWS;
+    } else {
+      v = GetFont(*txt_nextp - 32, i) | (GetFont(*txt_curp - 32, i) << 8);
+      coldata[i] = (v >> (8 - scrollstep)) & NDOTM_ALLROWS;
+    }
   }
 
+  if (!scrollstep)
+    dwell_ctr = dwell_div; // stop a while on each character
+}
+
+void NovaDotMatrix::WriteCol(uint8_t colno,uint8_t rowdat) {
+  //
+  // load display colno with data in rowdat
+  //
+  NDOTM_PROFILE_SITE(ndotm_prof_write_col);
+  uint8_t mask,sel;
+
+  // which of the column clocks is ours. the first one out ends up furthest
+  // along the shift registers
+  if (pin_end_is_top)
+    sel = colno;
+  else
+    sel = NDOTM_LASTCOL - colno;
+
   // column
   uint8_t i;
 
@@ -734,10 +1532,10 @@ void NovaDotMatrix::WriteCol(uint8_t colno,uint8_t rowdat) {
   //
   // column bits first
   //
-  for (i = 0;i < 5; i++) {
+  for (i = 0;i < NDOTM_NUMCOLS; i++) {
 
     // set data bit to 0 or 1
-    if (mask & colbit) 
+    if (i == sel) 
       PORTB &= ~NDOTM_SR_DAT_BIT; 
     else  
       PORTB |= NDOTM_SR_DAT_BIT; 
@@ -745,28 +1543,23 @@ void NovaDotMatrix::WriteCol(uint8_t colno,uint8_t rowdat) {
     // toggle clock
     PORTB &= ~NDOTM_SR_CLK_BIT; 
     PORTB |= NDOTM_SR_CLK_BIT; 
-
-    if (pin_end_is_top)
-      mask = mask >> 1;
-    else
-      mask = mask << 1;
-
-
   }
-  // extra clock for unused bit..
-  PORTB &= ~NDOTM_SR_CLK_BIT; 
-  PORTB |= NDOTM_SR_CLK_BIT; 
+  // extra clocks for unused bits..
+  for (i = 0;i < NDOTM_SR_GAP; i++) {
+    PORTB &= ~NDOTM_SR_CLK_BIT; 
+    PORTB |= NDOTM_SR_CLK_BIT; 
+  }
 
   //
   // now row bits
   //
   if (pin_end_is_top)
-    mask = 0b01000000;
+    mask = NDOTM_TOPROW_BIT;
   else
     mask = 0b00000001;
 
   col_num_leds_on = 0;
-  for (i = 0;i < 7; i++) {
+  for (i = 0;i < NDOTM_NUMROWS; i++) {
 
     if (mask & rowdat)  {
       PORTB &= ~NDOTM_SR_DAT_BIT; 
@@ -784,7 +1577,14 @@ void NovaDotMatrix::WriteCol(uint8_t colno,uint8_t rowdat) {
     else
       mask = mask << 1;
   }
-#if !defined(NDOTM_TESTING)
+#if defined(NDOTM_READY_LINE)
+  // enable column drivers, unless that would tell the master we're ready 
+  // when a byte is still waiting
+  DISABLE_INDATA_IRUPS;
+  if (!indata_available)
+    NDOTM_READY;
+  ENABLE_INDATA_IRUPS;
+#elif !defined(NDOTM_TESTING)
   PORTB &= ~NDOTM_BLANK_DATOUT_BIT; // enable column drivers
 #endif
 
@@ -795,11 +1595,7 @@ void NovaDotMatrix::ScrollAndDwellManage(void) {
   //
   // Scroll rate and Dwell period  
   //
-  if (!(attinytimer.OneHundredHzFlag))
-    return;
-
-  attinytimer.OneHundredHzFlag = false;
-
+  NDOTM_PROFILE_SITE(ndotm_prof_scroll_and_dwell);
   if (dwell_ctr) {
     dwell_ctr--;
   }
@@ -810,12 +1606,34 @@ void NovaDotMatrix::ScrollAndDwellManage(void) {
       scrollstep = 0;
 
     scroll_rate_ctr = scroll_rate_div;
+
+    if (buf_contents == NDOTM_BUF_CONTENTS_CANVAS && Mode == ModeNorm)
+      CanvasPan(drift_x, drift_y);
+
+    if (effect) {
+      if (buf_contents != NDOTM_BUF_CONTENTS_BINARY)
+        effect = ndotm_effect_off; // something else is showing. that's the end of it
+      else if (Mode == ModeNorm)
+        EffectStep();
+    }
   }
 
   if (Mode == ModeInTransition) {
     // transition is the period between display of data
     // display will be showing transition effects
 
+#ifdef NDOTM_TRANSITION_FX
+    if (transition_fx != ndotm_fx_cut) {
+      if (++fx_ctr >= fx_div) {
+        fx_ctr = 0;
+        fx_step++;
+      }
+      if (fx_step >= NDOTM_FX_STEPS) {
+        txt_curp = (char *)buf;
+        Mode = ModeNorm;
+      }
+    } else
+#endif
     if (transition_ctr++ > transition_max) {
       // when done, switch display mode back to norm
       txt_curp = (char *)buf;
@@ -872,6 +1690,10 @@ void NovaDotMatrix::DispTwoSmallChars(bool flip2char) {
    *
    */
 
+#if NDOTM_NUMCOLS > NDOTM_GLYPH_LEN
+  memset(coldata + NDOTM_GLYPH_LEN, 0, NDOTM_NUMCOLS - NDOTM_GLYPH_LEN); // only the first 5 columns are ours
+#endif
+
   uint8_t tmp[3];
   unsigned char c;
 
@@ -1091,6 +1913,127 @@ n 2   : 4   :  4  :  0
 
 }
 
+static uint8_t NdotmRandom(void) {
+  // xorshift, 16 bits of state. a few shifts, no multiply
+  static uint16_t s = 0xace1;
+  s ^= s << 7;
+  s ^= s >> 9;
+  s ^= s << 8;
+  return s;
+}
+
+void NovaDotMatrix::CmdEffect(void) {
+  // effect, and a setting for it
+  effect       = (params[0] <= ndotm_effect_meter) ? params[0] : (uint8_t)ndotm_effect_off;
+  effect_param = params[1];
+  if (effect == ndotm_effect_off)
+    return;
+
+  for (uint8_t i = 0; i < NDOTM_NUMCOLS; i++) {
+    if (buf_contents != NDOTM_BUF_CONTENTS_BINARY)
+      buf[i] = 0; // start from dark, or carry on from whatever frame they sent
+    buf[NDOTM_NUMCOLS + i] = 0;
+  }
+  if (buf_contents != NDOTM_BUF_CONTENTS_BINARY && effect == ndotm_effect_life)
+    EffectSeed();
+  NDOTM_DATA_DONE;
+}
+
+void NovaDotMatrix::EffectSeed(void) {
+  // random dots, effect_param out of 256 of them on
+  uint8_t density = effect_param ? effect_param : NDOTM_LIFE_DENSITY;
+
+  for (uint8_t i = 0; i < NDOTM_NUMCOLS; i++) {
+    buf[i] = 0;
+    for (uint8_t r = 0; r < NDOTM_NUMROWS; r++)
+      if (NdotmRandom() < density)
+        buf[i] |= 1 << r;
+    buf[NDOTM_NUMCOLS + i] = 0;
+  }
+}
+
+// life, all the dots of a column at once
+#define ROW_UP(x)   ((((x) << 1) | ((x) >> (NDOTM_NUMROWS - 1))) & NDOTM_ALLROWS)
+#define ROW_DOWN(x) ((((x) >> 1) | ((x) << (NDOTM_NUMROWS - 1))) & NDOTM_ALLROWS)
+#define LIFE_ADD(x) { \
+  /* add a neighbour to the count. s2 s1 s0 are its bits, one row a bit */ \
+  uint8_t _a = (x), _c0, _c1; \
+  _c0 = s0 & _a; s0 ^= _a; \
+  _c1 = s1 & _c0; s1 ^= _c0; \
+  s2 ^= _c1; /* 8 comes out as 0, which is as dead as 4 or more */ \
+}
+
+void NovaDotMatrix::EffectStep(void) {
+  //
+  // next generation of the effect, straight into the frame in buf. a byte
+  // a column as with ndotm_cmd_data, bit 0 the bottom row
+  //
+  NDOTM_PROFILE_SITE(ndotm_prof_effect_step);
+  uint8_t nxt[NDOTM_NUMCOLS];
+  uint8_t *prev = buf + NDOTM_NUMCOLS; // generation before, life only
+  uint8_t i, l, c, r, s0, s1, s2, h, t;
+  bool still = true, blinking = true;
+
+  switch (effect) {
+    case ndotm_effect_life:
+      // wraps round top to bottom and side to side
+      for (i = 0; i < NDOTM_NUMCOLS; i++) {
+        l  = buf[i ? i - 1 : NDOTM_LASTCOL];
+        c  = buf[i];
+        r  = buf[i < NDOTM_LASTCOL ? i + 1 : 0];
+        s0 = s1 = s2 = 0;
+        LIFE_ADD(ROW_UP(l)); LIFE_ADD(l); LIFE_ADD(ROW_DOWN(l));
+        LIFE_ADD(ROW_UP(c));              LIFE_ADD(ROW_DOWN(c));
+        LIFE_ADD(ROW_UP(r)); LIFE_ADD(r); LIFE_ADD(ROW_DOWN(r));
+        nxt[i] = s1 & ~s2 & (s0 | c); // 3 neighbours, or 2 and alive already
+        if (nxt[i] != c)
+          still = false;
+        if (nxt[i] != prev[i])
+          blinking = false;
+      }
+      if (still || blinking) {
+        // died out, or stuck. start again
+        EffectSeed();
+        break;
+      }
+      for (i = 0; i < NDOTM_NUMCOLS; i++) {
+        prev[i] = buf[i];
+        buf[i]  = nxt[i];
+      }
+      break;
+
+    case ndotm_effect_sparks:
+      // sparks drift up and die off, new ones start at the bottom
+      for (i = 0; i < NDOTM_NUMCOLS; i++) {
+        c = (buf[i] << 1) & NDOTM_ALLROWS & (NdotmRandom() | NdotmRandom());
+        if (NdotmRandom() < effect_param)
+          c |= 1;
+        buf[i] = c;
+      }
+      break;
+
+    case ndotm_effect_meter:
+      // bars jump up to around the level, and fall back a dot at a time
+      for (i = 0; i < NDOTM_NUMCOLS; i++) {
+        for (h = 0; buf[i] >> h; h++)
+          ;
+        t = NdotmRandom() & 0b00000011;
+        t = (effect_param > t) ? effect_param - t : 0;
+        if (t > NDOTM_NUMROWS)
+          t = NDOTM_NUMROWS;
+        if (t > h)
+          h = t;
+        else if (h)
+          h--;
+        buf[i] = (1 << h) - 1;
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
 #ifdef NDOTM_COMPILE_DEMO
 
 static uint8_t GetRandomGraph(void) {
@@ -1144,13 +2087,6 @@ static void RandomCrawlingGraph(uint8_t dir) {
     demo_step_ctr = 2; 
   } 
 }
-uint8_t myrandom(void) {
-  static uint16_t adr = 0x1000;
-  if (adr++ > 4096)
-    adr = 0x40;
-  return pgm_read_byte(adr); 
-
-}
 
 static void RandomCrawl(uint8_t dir) { 
   uint8_t c;
@@ -1176,7 +2112,7 @@ static void RandomCrawl(uint8_t dir) {
 
     c = 0; 
     for (uint8_t i = 0; i < NDOTM_NUMROWS; i++) { 
-      c |= ((myrandom()>>1) > 100) ? (1 << i) : 0; 
+      c |= ((NdotmRandom()>>1) > 100) ? (1 << i) : 0; 
     } 
     WRITE_SELF(c); 
 
@@ -1192,6 +2128,7 @@ static void DemoManage() {
   //
   // sequencing of demos done here.
   //
+  NDOTM_PROFILE_SITE(ndotm_prof_demo_manage);
 #define START_DEMO 0
 #define END_DEMO 17
 #define MAX_DEMO 17  // highest #'d demo
@@ -1206,10 +2143,7 @@ static void DemoManage() {
   static char demo_buf[BUFSIZE];
 #define SCROLL_TEXT_MESSAGE "01234567890ABCDEF" //  }; // = { "WELCOME TO NOVA LABS..." };
 
-if (!(attinytimer.FiftyHzFlag)) // everything gets done at 50hz intervals
-  return;
-  attinytimer.FiftyHzFlag = false;
-
+  // everything gets done every NDOTM_DEMO_TICKS
 
 #if 0
   static uint8_t subdiv = 10;
@@ -1573,45 +2507,71 @@ if (!(--demo_switch_ctr)) {
 
 
 
+#ifdef NDOTM_RX_USI
+ISR(USI_OVF_vect)
+{
+  //
+  // the USI has shifted in a whole byte from the master
+  //
+  NDOTM_PROFILE_SITE(ndotm_prof_isr_pcint);
+  uint8_t c = USIBR; // buffered copy, safe from the next clock edge
+
+  USISR = _BV(USIOIF) | (USISR & 0b00001111); // ack, keeping any edges since
+
+  if (ndotm_instance->indata_available) // upstairs hasn't taken the last one. this one is lost
+    return;
+
+  ndotm_instance->indata           = c;
+  ndotm_instance->indata_available = true;
+#ifdef NDOTM_READY_LINE
+  NDOTM_BUSY;
+#endif
+  ndotm_instance->indata_idle_ctr  = 0;
+}
+#else
 ISR(PCINT0_vect) 
 {
   // 
   // interrupts from external master clock line come here
   // 
-  bool clk_in_high = *portInputRegister(novadotmatrix.indata_port) & NDOTM_CLK_IN_BIT;
-  static uint8_t indata_raw;
+  NDOTM_PROFILE_SITE(ndotm_prof_isr_pcint);
+  bool clk_in_high = *portInputRegister(ndotm_instance->indata_port) & NDOTM_CLK_IN_BIT;
 
-  if (novadotmatrix.demo)
+  if (ndotm_instance->demo)
     return;
 
-  if (novadotmatrix.indata_available  || !clk_in_high) {
+  if (ndotm_instance->indata_available  || !clk_in_high) {
     // we've already told them upstairs so nothing to do until
     // they clear indata_available
     //NDOTM_BLIP_ON_SCOPE(1);
     return;
   }
-  novadotmatrix.indata_idle_ctr = 0;
+  ndotm_instance->indata_idle_ctr = 0;
   if (clk_in_high) {
 
-    /* !novadotmatrix.indata_available && <- already tested */ // ignore next incoming if top loop hasn't grabbed data (this should be an error)
+    /* !ndotm_instance->indata_available && <- already tested */ // ignore next incoming if top loop hasn't grabbed data (this should be an error)
     // it is actually an interrupt on change and we are only interested in when the clock level is high
-    // *portInputRegister(novadotmatrix.indata_port) & NDOTM_CLK_IN_BIT) { // (don't know why PORTB & NDOTM_CLK_IN_BIT doesn't work)
+    // *portInputRegister(ndotm_instance->indata_port) & NDOTM_CLK_IN_BIT) { // (don't know why PORTB & NDOTM_CLK_IN_BIT doesn't work)
     // if clock is high 
-    if (*portInputRegister(novadotmatrix.indata_port) & NDOTM_DAT_IN_BIT)  {
+    if (*portInputRegister(ndotm_instance->indata_port) & NDOTM_DAT_IN_BIT)  {
       // then if data is high
-      //novadotmatrix.indata |= (1 << novadotmatrix.indata_cur_bit); // set next received bit 
-      indata_raw |= (1 << novadotmatrix.indata_cur_bit); // set next received bit 
+      //ndotm_instance->indata |= (1 << ndotm_instance->indata_cur_bit); // set next received bit 
+      ndotm_instance->indata_raw |= (1 << ndotm_instance->indata_cur_bit); // set next received bit 
     }
-    if (!novadotmatrix.indata_cur_bit) {
-      novadotmatrix.indata = indata_raw;
-      indata_raw = 0;
-      novadotmatrix.indata_available = true;
-      novadotmatrix.indata_cur_bit = 7;
+    if (!ndotm_instance->indata_cur_bit) {
+      ndotm_instance->indata = ndotm_instance->indata_raw;
+      ndotm_instance->indata_raw = 0;
+      ndotm_instance->indata_available = true;
+#ifdef NDOTM_READY_LINE
+      NDOTM_BUSY;
+#endif
+      ndotm_instance->indata_cur_bit = 7;
     } else {
-      novadotmatrix.indata_cur_bit--;
+      ndotm_instance->indata_cur_bit--;
     }
 
-    novadotmatrix.indata_idle_ctr = 0;
+    ndotm_instance->indata_idle_ctr = 0;
   }
 
   }
+#endif // NDOTM_RX_USI
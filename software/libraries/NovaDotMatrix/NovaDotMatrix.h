@@ -20,12 +20,19 @@
 #ifndef NovaDotMatrix_h
 #define NovaDotMatrix_h
 #include "Arduino.h"
-#include "ATTinyTimer.h"
+#include "ATtinyTimer.h"
 
 //#define NDOTM_TESTING // mostly for scope blip borrows blanking pin
+//#define NDOTM_PROFILE // time hot spots with Timer0. ndotm_cmd_diag ndotm_diag_profile reads them
+//#define NDOTM_RX_USI  // let the USI shift in whole bytes from the master instead of PCINT per bit
+//#define NDOTM_READY_LINE // data out pin high while we can't take another byte. not with NDOTM_TESTING
 
-#define NDOTM_DEMO_TEN_HZ_BIT       0b00000001       // our bit in the timer's flag byte
-#define NDOTM_MANAGE_HUNDRED_HZ_BIT 0b00000001 // our bit in the timer's flag byte
+// how often things happen, in attinytimer fast ticks
+#define NDOTM_REFRESH_TICKS       2  // each column stays lit this long
+#define NDOTM_REFRESH_SHORT_TICKS 1  // ..or this long when few leds are on
+#define NDOTM_SCROLL_TICKS        11 // scroll rate and dwell count in these
+#define NDOTM_DEMO_TICKS          11 // demo steps
+#define NDOTM_IDLE_TICKS          1  // checking for a stalled master
 
 // Pin Assignments
 // display control
@@ -51,12 +58,34 @@
 #define NDOTM_DAT_IN_PIN       PB0         // data from host
 #define NDOTM_DAT_IN_BIT       0b00000001
 
+// Panel geometry. A column is one byte, bit 0 the bottom row, so up to 8 
+// rows. Columns are limited by the 4 bit length in the command table. 
+// Text is drawn in the first 5 columns. The shift registers take the 
+// column bits, then NDOTM_SR_GAP unused bits, then the row bits, so rows 
+// fill the first register and columns start in the second.
+#ifndef NDOTM_NUMROWS
+#define NDOTM_NUMROWS 7
+#endif
+#ifndef NDOTM_NUMCOLS
+#define NDOTM_NUMCOLS 5
+#endif
+#if NDOTM_NUMROWS > 8 || NDOTM_NUMCOLS < 5 || NDOTM_NUMCOLS > 15
+#error NDOTM_NUMROWS can be 1 to 8, NDOTM_NUMCOLS 5 to 15
+#endif
+#define NDOTM_LASTCOL    (NDOTM_NUMCOLS - 1)
+#define NDOTM_TOPROW_BIT (1 << (NDOTM_NUMROWS - 1))
+#define NDOTM_ALLROWS    ((uint8_t)((1 << NDOTM_NUMROWS) - 1))
+#define NDOTM_SR_GAP     (8 - NDOTM_NUMROWS)
+
+#if NDOTM_NUMCOLS == 5 && NDOTM_NUMROWS == 7
+#define NDOTM_TRANSITION_FX // wipes, dissolve and push between frames. TransitionMasks.h is drawn for 5x7
+#endif
+
 class NovaDotMatrix
 {
   public:
     void Setup(void);  // call once
     void Loop(void); // call continuously
-    inline void CommonLoopChores(void); 
     uint8_t Mode;
     uint8_t NextMode;
     enum mode { 
@@ -72,23 +101,25 @@ class NovaDotMatrix
     // communications from master
     volatile uint8_t indata;
     volatile bool indata_available;
-    volatile uint8_t indata_cur_bit;
+    volatile uint8_t indata_cur_bit; // with NDOTM_RX_USI, the USI edge count at the last idle check
+    volatile uint8_t indata_raw;     // bits so far, PCINT receive only
     volatile uint8_t indata_idle_ctr;
     const uint8_t indata_idle_max = 2;
-    const uint8_t indata_fast_ctr_flag_bit = 0b00000001;
 
     uint8_t shift_dir;
+    uint8_t scroll_dir; // ndotm_scroll_ way messages move
 
     uint8_t indata_state;
     enum indata_state {
-      indata_state_norm_buf_ascii,
-      indata_state_norm_buf_raw,
       indata_state_norm,
-      indata_state_rx_single_cmd_opcode,
-      indata_state_rx_double_cmd_opcode,
-      indata_state_rx_data,
-      indata_state_rx_data_single_byte_for_scroll,
-      indata_state_rx_message
+      indata_state_rx_params,
+      indata_state_rx_string,
+      // packet states last
+      indata_state_pkt_hunt,
+      indata_state_rx_packet_len,
+      indata_state_rx_packet_body,
+      indata_state_rx_packet_crc,
+      indata_state_rx_canvas // counted too, so given up on if the line goes quiet
     };
     uint8_t indata_port;
     void ProcessInData(void);
@@ -104,12 +135,118 @@ class NovaDotMatrix
     uint8_t transition_ctr; // period we stay
     uint8_t transition_max; // counts up 
 #define NDOTM_TRANSITION_MAX 2
+#ifdef NDOTM_TRANSITION_FX
+    void FxStart(void);
+    void FxDraw(uint8_t);
+    uint8_t transition_fx;          // ndotm_fx_ asked for
+    uint8_t fx;                     // ..and the one running, mirrored if flipped
+    uint8_t fx_step, fx_ctr, fx_div;
+    uint8_t fx_old[NDOTM_NUMCOLS];  // frame we are going from
+    uint8_t fx_new[NDOTM_NUMCOLS];  // frame we are going to
+#endif
 
 private:
+    void RxByte(uint8_t);
+    void RxCmd(uint8_t);
+    void RxParam(uint8_t);
+    bool Utf8(uint8_t &);
+    uint8_t utf8_lead, utf8_left; // UTF-8 character we're in the middle of
+    bool last_char_was_esc;
+    uint8_t last_cmd;
+
+    // command table. see NovaDotMatrix.cpp
+    typedef void (NovaDotMatrix::*cmd_handler)(void);
+    struct cmd_entry {
+      uint8_t opcode;
+      uint8_t len;         // parameter bytes | NDOTM_CMD_ flags
+      cmd_handler handler; // called when the parameters are in
+    };
+#define NDOTM_CMD_LEN_MASK 0b00001111
+#define NDOTM_CMD_COUNTED  0b00010000
+#define NDOTM_CMD_STRING   0b00100000
+#define NDOTM_CMD_RAW      0b01000000
+    static const cmd_entry cmd_table[];
+    cmd_entry cmd; // one we are collecting parameters for
+#define NDOTM_MAX_PARAMS (NDOTM_NUMCOLS > 6 ? NDOTM_NUMCOLS : 6) // ndotm_cmd_data takes a column each
+    uint8_t params[NDOTM_MAX_PARAMS];
+    uint8_t ctr;   // parameter bytes so far
+
+    void CmdReset(void);
+    void CmdMessage(void);
+    void CmdFlip(void);
+    void CmdNoflip(void);
+    void CmdFont(void);
+    void CmdDwell(void);
+    void CmdRate(void);
+    void CmdTransition(void);
+    void CmdTransitionFx(void);
+    void CmdData(void);
+    void CmdDataScroll(void);
+    void CmdChar(void);
+    void CmdShiftDir(void);
+    void Cmd2ch(void);
+    void CmdCol(void);
+    void CmdCols(void);
+    void CmdPixels(void);
+    void CmdPacket(void);
+    void CmdDiag(void);
+    void CmdCounter(void);
+    void CmdCountUp(void);
+    void CmdCountDown(void);
+    void CmdCountAdd(void);
+    void CounterShow(int8_t);
+    uint8_t counter_val;
+    uint8_t counter_flags; // ndotm_counter_
+    void CmdPlaylistStore(void);
+    void CmdPlaylist(void);
+    void PlaylistNext(void);
+    uint8_t playlist_first, playlist_count, playlist_cur;
+#define NDOTM_PLAYLIST_EEPROM   0 // where the slots start
+#define NDOTM_PLAYLIST_SLOT_LEN (3 + NDOTM_MSGLEN + 1) // dwell, rate, flags, message
+    void CmdGlyph(void);
+#define NDOTM_GLYPH_EEPROM (NDOTM_PLAYLIST_EEPROM + NDOTM_PLAYLIST_SLOTS * NDOTM_PLAYLIST_SLOT_LEN)
+#define NDOTM_GLYPH_LEN    5 // font width, whatever the panel
+    void CmdScrollDir(void);
+    void CmdEffect(void);
+    void EffectStep(void);
+    void EffectSeed(void);
+    uint8_t effect;       // ndotm_effect_ running on the frame in buf
+    uint8_t effect_param; // ..and its setting
+#define NDOTM_LIFE_DENSITY 80 // out of 256, for a fresh start with no setting
+    void VScrollStep(void);
+    void CmdCanvas(void);
+    void CmdView(void);
+    void CmdPan(void);
+    void CmdDrift(void);
+    void CanvasPan(int8_t, int8_t);
+    uint8_t CanvasCol(uint8_t);
+    uint8_t canvas_w, canvas_ctr; // canvas columns kept in buf, and loaded so far
+    uint8_t view_x, view_y;       // canvas column and row at the panel's top left
+    int8_t drift_x, drift_y;      // view moves this much each scroll step
+
+    void DiagWrite(uint8_t);
+
+#define NDOTM_PKT_MAXLEN 40   // biggest packet body we will take
+#define NDOTM_PKT_IDLE_MAX 50 // fast ticks of quiet before we give up on a packet
+    void DispatchPacket(void);
+    uint8_t pkt_buf[NDOTM_PKT_MAXLEN];
+    uint8_t pkt_len;
+    uint8_t pkt_ctr;
+    uint8_t pkt_crc;
+    uint8_t pkt_idle_ctr;
+
     void Chores(void);
     void ScrollAndDwellManage(void);
+    void IdleManage(void);
+
+    // attinytimer tasks
+    static uint8_t RefreshTask(void);
+    static uint8_t ScrollTask(void);
+    static uint8_t IdleTask(void);
+    static uint8_t DemoTask(void);
     void WriteCol(uint8_t, uint8_t); 
     void WriteNextCol(void);
+    void DrawFrame(void);
     void DispTwoSmallChars(bool);
 
     uint8_t scroll_rate_ctr;
@@ -132,8 +269,6 @@ private:
 
     uint8_t col_ctr;
     uint8_t col_num_leds_on;
-#define NDOTM_NUMROWS 7 
-#define NDOTM_NUMCOLS 5
     uint8_t coldata[NDOTM_NUMCOLS];
     uint8_t scrollstep;
     uint8_t lastscrollstep;
@@ -141,16 +276,31 @@ private:
     bool flip2char;
 
 #define NDOTM_BUFLEN 64
+#define NDOTM_MSGLEN 32 // longest scrolling message
     uint8_t buf[NDOTM_BUFLEN];
     uint8_t buf_contents;
 #define NDOTM_BUF_CONTENTS_ASCII 0
 #define NDOTM_BUF_CONTENTS_2ASCII 1
 #define NDOTM_BUF_CONTENTS_BINARY 2
+#define NDOTM_BUF_CONTENTS_CANVAS 3
 
 }; 
 
+// the board the tasks and interrupts work on. Setup() points it at its 
+// object. A host build simulating many boards can define 
+// NDOTM_INSTANCE_STORAGE as thread_local and switch it per board
+#ifndef NDOTM_INSTANCE_STORAGE
+#define NDOTM_INSTANCE_STORAGE
+#endif
+extern NDOTM_INSTANCE_STORAGE NovaDotMatrix *ndotm_instance;
+
+#ifdef NDOTM_RX_USI
+#define ENABLE_INDATA_IRUPS  USICR  |=  _BV(USIOIE);
+#define DISABLE_INDATA_IRUPS  USICR &= ~_BV(USIOIE);
+#else
 #define ENABLE_INDATA_IRUPS  GIMSK  |=  0b00100000;
 #define DISABLE_INDATA_IRUPS  GIMSK &= ~0b00100000;
+#endif
 
 #define NDOTM_NOPS \
   __asm__ __volatile__ (\
@@ -185,41 +335,70 @@ ENABLE_TIMER_IRUPS; \
 #define NDOTM_BLIP_ON_SCOPE 
 #endif
 
+#ifdef NDOTM_READY_LINE
+// Flow control for the master. The data out pin doubles as blanking, so it
+// is already high while a column loads. It also goes high when a byte lands
+// in indata, and low again once ProcessInData() has taken it. The display 
+// is dark for that long.
+#define NDOTM_BUSY  PORTB |= NDOTM_DAT_OUT_BIT
+#define NDOTM_READY PORTB &= ~NDOTM_DAT_OUT_BIT
+#endif
+
+#ifdef NDOTM_PROFILE
+// Put NDOTM_PROFILE_SITE(ndotm_prof_...) at the top of a function and each 
+// call is timed in Timer0 counts, entry to return. Timer0 is 8 bits, so 
+// anything slower than a full Timer0 wrap will read short.
+struct NdotmProfEntry {
+  uint16_t count;  // calls (stops at 0xffff)
+  uint8_t min;
+  uint8_t max;
+  uint32_t total;
+};
+extern NdotmProfEntry ndotm_prof[];
+void NdotmProfClear(void);
+void NdotmProfRecord(uint8_t, uint8_t);
+
+struct NdotmProfSite {
+  uint8_t site, start;
+  NdotmProfSite(uint8_t s) : site(s), start(TCNT0) { }
+  ~NdotmProfSite() { NdotmProfRecord(site, start); }
+};
+#define NDOTM_PROFILE_SITE(s) NdotmProfSite _ndotm_prof_site(s)
+#else
+#define NDOTM_PROFILE_SITE(s)
+#endif
+
 #define NDOTM_WRITE_AND_UPDATE_COL_COUNTER \
 { \
   /* basic act of multiplex; write one column at at a time */ \
   WriteCol(col_ctr,coldata[col_ctr]); \
   col_ctr++; \
-  if (col_ctr > 4) \
+  if (col_ctr > NDOTM_LASTCOL) \
   col_ctr = 0; \
 } \
 
 /* Display operations */
 
 #define SHIFT_LEFT_WRAP(b) { \
-  uint8_t tmp =  b[0]; \
-  b[0] = b[1]; \
-  b[1] = b[2]; \
-  b[2] = b[3]; \
-  b[3] = b[4]; \
-  b[4] = tmp; \
+  uint8_t tmp =  b[0], i; \
+  for (i = 0; i < NDOTM_LASTCOL; i++) \
+    b[i] = b[i + 1]; \
+  b[NDOTM_LASTCOL] = tmp; \
 }
 
 #define SHIFT_RIGHT_WRAP(b) { \
-  uint8_t tmp =  b[4]; \
-  b[4] = b[3]; \
-  b[3] = b[2]; \
-  b[2] = b[1]; \
-  b[1] = b[0]; \
+  uint8_t tmp =  b[NDOTM_LASTCOL], i; \
+  for (i = NDOTM_LASTCOL; i > 0; i--) \
+    b[i] = b[i - 1]; \
   b[0] = tmp; \
 }
 
 #define SHIFT_UP_WRAP(b) { \
   uint8_t btmp,i; \
   for (i = 0; i < NDOTM_NUMCOLS; i++)  { \
-    btmp = b[i] & 0b01000000; /* save msb */ \
-    b[i] = (b[i] << 1) | /* shift up */ \
-    (btmp >> 6); /* with msb in lsb */ \
+    btmp = b[i] & NDOTM_TOPROW_BIT; /* save msb */ \
+    b[i] = ((b[i] << 1) & NDOTM_ALLROWS) | /* shift up */ \
+    (btmp >> (NDOTM_NUMROWS - 1)); /* with msb in lsb */ \
   } \
 }
 
@@ -229,14 +408,14 @@ ENABLE_TIMER_IRUPS; \
   for (i = 0; i < NDOTM_NUMCOLS; i++)  { \
     btmp = b[i] & 0b00000001; /* save lsb */ \
     b[i] = (b[i] >> 1) | /* shift down */ \
-    (btmp << 6); /* replace msb with lsb */ \
+    (btmp << (NDOTM_NUMROWS - 1)); /* replace msb with lsb */ \
   } \
 }
 
 #define WRITE_SELF(c) { /* fake sending data to ourselves for demo */ \
-  novadotmatrix.indata = c; \
-  novadotmatrix.indata_available = true; \
-  novadotmatrix.ProcessInData(); \
+  ndotm_instance->indata = c; \
+  ndotm_instance->indata_available = true; \
+  ndotm_instance->ProcessInData(); \
 }
 
 
@@ -0,0 +1,62 @@
+#ifndef TRANSITIONMASKS
+
+// Masks for the ndotm_cmd_transition_fx wipes and dissolve, drawn for the 
+// 5x7 panel. For each effect, NDOTM_FX_STEPS rows of one byte per column, 
+// left to right with the lsb the top row. A 1 shows the new frame. 
+// 5 of them at 40 bytes is 200 bytes of flash.
+
+#include <avr/pgmspace.h> // to get PROGMEM typedefs
+
+#define NDOTM_FX_STEPS      8
+#define NDOTM_FX_MASK_LEN   (NDOTM_FX_STEPS * 5)
+
+const PROGMEM uint8_t fx_masks[] = {
+  // wipe left, new frame in from the right
+  0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x7F,
+  0x00, 0x00, 0x00, 0x00, 0x7F,
+  0x00, 0x00, 0x00, 0x7F, 0x7F,
+  0x00, 0x00, 0x7F, 0x7F, 0x7F,
+  0x00, 0x00, 0x7F, 0x7F, 0x7F,
+  0x00, 0x7F, 0x7F, 0x7F, 0x7F,
+  0x00, 0x7F, 0x7F, 0x7F, 0x7F,
+  // wipe right
+  0x00, 0x00, 0x00, 0x00, 0x00,
+  0x7F, 0x00, 0x00, 0x00, 0x00,
+  0x7F, 0x00, 0x00, 0x00, 0x00,
+  0x7F, 0x7F, 0x00, 0x00, 0x00,
+  0x7F, 0x7F, 0x7F, 0x00, 0x00,
+  0x7F, 0x7F, 0x7F, 0x00, 0x00,
+  0x7F, 0x7F, 0x7F, 0x7F, 0x00,
+  0x7F, 0x7F, 0x7F, 0x7F, 0x00,
+  // wipe up, new frame in from the bottom
+  0x00, 0x00, 0x00, 0x00, 0x00,
+  0x40, 0x40, 0x40, 0x40, 0x40,
+  0x60, 0x60, 0x60, 0x60, 0x60,
+  0x70, 0x70, 0x70, 0x70, 0x70,
+  0x78, 0x78, 0x78, 0x78, 0x78,
+  0x78, 0x78, 0x78, 0x78, 0x78,
+  0x7C, 0x7C, 0x7C, 0x7C, 0x7C,
+  0x7E, 0x7E, 0x7E, 0x7E, 0x7E,
+  // wipe down
+  0x00, 0x00, 0x00, 0x00, 0x00,
+  0x01, 0x01, 0x01, 0x01, 0x01,
+  0x03, 0x03, 0x03, 0x03, 0x03,
+  0x07, 0x07, 0x07, 0x07, 0x07,
+  0x0F, 0x0F, 0x0F, 0x0F, 0x0F,
+  0x0F, 0x0F, 0x0F, 0x0F, 0x0F,
+  0x1F, 0x1F, 0x1F, 0x1F, 0x1F,
+  0x3F, 0x3F, 0x3F, 0x3F, 0x3F,
+  // dissolve, in a fixed scattered order
+  0x00, 0x00, 0x00, 0x00, 0x00,
+  0x30, 0x00, 0x02, 0x00, 0x02,
+  0x30, 0x28, 0x03, 0x04, 0x12,
+  0x31, 0x28, 0x03, 0x45, 0x32,
+  0x31, 0x2B, 0x03, 0x47, 0x73,
+  0x31, 0x6B, 0x23, 0x4F, 0x77,
+  0x73, 0x6B, 0x37, 0x4F, 0x77,
+  0x77, 0x7B, 0x3F, 0x6F, 0x7F
+};
+
+#define TRANSITIONMASKS
+#endif
@@ -36,6 +36,242 @@ enum ndotm_command {
   ndotm_cmd_shift_dir,   // shift data direction
   ndotm_cmd_2ch,         // write 2 small characters
   ndotm_cmd_2ch_flipped, // write 2 small characters flipped
+  ndotm_cmd_col,         // load one column
+  ndotm_cmd_cols,        // load a range of columns
+  ndotm_cmd_pixels,      // set/clear/toggle rows in a set of columns
+  ndotm_cmd_packet,      // length counted, crc checked batch of commands
+  ndotm_cmd_diag,        // send diagnostics back
+  ndotm_cmd_counter,     // show a number the board keeps
+  ndotm_cmd_count_up,    // counter + 1
+  ndotm_cmd_count_down,  // counter - 1
+  ndotm_cmd_count_add,   // counter + signed delta
+  ndotm_cmd_playlist_store, // keep a message in eeprom
+  ndotm_cmd_playlist,    // scroll through stored messages
+  ndotm_cmd_glyph,       // define a character of our own
+  ndotm_cmd_canvas,      // load a picture wider than the panel
+  ndotm_cmd_view,        // show part of it
+  ndotm_cmd_pan,         // move the view
+  ndotm_cmd_drift,       // keep moving the view
+  ndotm_cmd_scroll_dir,  // which way messages scroll
+  ndotm_cmd_transition_fx, // how one frame gives way to the next
+  ndotm_cmd_effect,      // let the board animate by itself
 
   ndotm_cmd_max,              // marker for last command
 };
+
+// Partial frame updates. Columns are numbered in the order they are sent 
+// with ndotm_cmd_data, and apply to the last frame loaded.
+//
+//   ndotm_cmd_col    <col> <data>
+//   ndotm_cmd_cols   <(count << 4) | first col> <data> ... <data>
+//   ndotm_cmd_pixels <ndotm_pix_op | colmask> <rowmask>
+//
+// colmask bit n selects column n, for the first NDOTM_PIX_COLS columns.
+// Use ndotm_cmd_col or ndotm_cmd_cols beyond those. The ops have the msb set so the 
+// first parameter of ndotm_cmd_pixels can never look like an escape
+enum ndotm_pix_op {
+  ndotm_pix_set    = 0b10000000, // turn rowmask bits on
+  ndotm_pix_clear  = 0b10100000, // turn rowmask bits off
+  ndotm_pix_toggle = 0b11000000, // flip rowmask bits
+};
+#define NDOTM_PIX_OP_MASK  0b11100000
+#define NDOTM_PIX_COL_MASK 0b00011111
+#define NDOTM_PIX_COLS     5 // columns colmask can reach, on wider panels too
+
+// Packets
+//
+//   <esc> ndotm_cmd_packet <len> <body: len bytes> <crc>
+//
+// The body is one or more commands packed as <opcode> <parameters>, 
+// without escapes. Nothing inside a packet is treated as an escape, so 
+// data can take any value. ndotm_cmd_char takes the character to show 
+// as its parameter. crc is ndotm_crc8() over len and the body.
+//
+// A packet that fails its crc is dropped, and everything after it is 
+// ignored until the next <esc> ndotm_cmd_packet, <esc> ndotm_cmd_reset,
+// or a pause in the data.
+
+inline uint8_t ndotm_crc8(uint8_t crc, uint8_t c) {
+  // CRC-8, polynomial x^8 + x^2 + x + 1
+  crc ^= c;
+  for (uint8_t i = 0; i < 8; i++)
+    crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+  return crc;
+}
+
+// Diagnostics
+//
+//   <esc> ndotm_cmd_diag <what>
+//
+// The board answers on its data out pin as 8N1 async serial, lsb first, 
+// NDOTM_DIAG_BIT_US per bit. The line is held high (display dark) for 
+// NDOTM_DIAG_PREAMBLE_BITS first so the listener can tell it from 
+// the blanking pulses.
+//
+//   ndotm_diag_timer: <ndotm_diag_timer> <max backlog> <lag lo> <lag hi> <lost>
+//   ndotm_diag_profile: <ndotm_diag_profile> <sites> <Timer0 clock select>
+//                       then for each ndotm_prof_ site
+//                       <calls lo> <calls hi> <min> <max> <total, 4 bytes lsb first>
+//                       times are in Timer0 counts. sites is 0 unless the
+//                       board was built with NDOTM_PROFILE
+//
+// Add NDOTM_DIAG_CLEAR to <what> to zero the counters after sending them.
+enum ndotm_diag {
+  ndotm_diag_timer = 1, // attinytimer lost tick accounting
+  ndotm_diag_profile,   // NDOTM_PROFILE timings
+};
+
+enum ndotm_prof_site {
+  ndotm_prof_write_col,
+  ndotm_prof_write_next_col,
+  ndotm_prof_process_in_data,
+  ndotm_prof_scroll_and_dwell,
+  ndotm_prof_demo_manage,
+  ndotm_prof_isr_pcint,        // USI_OVF_vect with NDOTM_RX_USI
+  ndotm_prof_isr_timer,
+  ndotm_prof_effect_step,
+
+  ndotm_prof_max,       // marker for last site
+};
+#define NDOTM_DIAG_CLEAR         0b10000000
+#define NDOTM_DIAG_WHAT_MASK     0b01111111
+#define NDOTM_DIAG_BIT_US        104 // 9600 baud
+#define NDOTM_DIAG_PREAMBLE_BITS 20
+#define NDOTM_DIAG_TIMER_LEN     5
+#define NDOTM_DIAG_PROFILE_SITE_LEN 8
+#define NDOTM_DIAG_PROFILE_LEN   (3 + ndotm_prof_max * NDOTM_DIAG_PROFILE_SITE_LEN)
+
+// Counter
+//
+//   ndotm_cmd_counter    <ndotm_counter_ flags> <value>
+//   ndotm_cmd_count_up
+//   ndotm_cmd_count_down
+//   ndotm_cmd_count_add  <delta, -128 to 127>
+//
+// The board keeps the value and redraws it, as two small digits or one big
+// one, so a change costs the master two or three bytes. Parameters are 
+// taken as is, so the value can be the escape code. Past the end of the 
+// range the count sticks, unless ndotm_counter_wrap is set.
+enum ndotm_counter_flag {
+  ndotm_counter_flipped = 0b00000001, // as ndotm_cmd_2ch_flipped
+  ndotm_counter_wrap    = 0b00000010, // 99 + 1 is 0 and 0 - 1 is 99
+  ndotm_counter_big     = 0b00000100, // one 5x7 digit, 0 to 9
+  ndotm_counter_blank0  = 0b00001000, // leading blank instead of a zero
+};
+
+// Playlist
+//
+//   ndotm_cmd_playlist_store <slot> <dwell> <rate> <ndotm_playlist_ flags> <message> <0>
+//   ndotm_cmd_playlist       <first slot> <count>
+//
+// The board keeps up to NDOTM_PLAYLIST_SLOTS messages in eeprom, each with
+// its own dwell, rate, font and flip. Once started, it moves on to the next
+// slot each time a message has scrolled all the way through, and goes 
+// round until a count of 0, ndotm_cmd_message or ndotm_cmd_reset. Empty 
+// slots are skipped. 
+//
+// Writing eeprom takes about 3.4 ms a byte and the board does nothing else
+// meanwhile, so anything sent then is lost. After the 0 that ends
+// ndotm_cmd_playlist_store, wait NDOTM_PLAYLIST_STORE_MS before sending more.
+#define NDOTM_PLAYLIST_STORE_MS 125 // dwell, rate, flags, 32 characters and the 0
+enum ndotm_playlist_flag {
+  ndotm_playlist_3x5  = 0b00000001, // small font
+  ndotm_playlist_flip = 0b00000010, // upside down
+};
+#define NDOTM_PLAYLIST_SLOTS 8
+
+// Glyphs
+//
+//   ndotm_cmd_glyph <code> <col 0> <col 1> <col 2> <col 3> <col 4>
+//
+// Character codes NDOTM_GLYPH_FIRST on are ours to draw. Columns are left
+// to right with the lsb the top row, as in FontAlphaNum57.h. The small 
+// font shows the first three columns. They are kept in eeprom, so they 
+// last, and can go in messages and playlists like any other character.
+// One that was never drawn shows as a blank.
+#define NDOTM_GLYPH_FIRST 0x90
+#define NDOTM_GLYPHS      8
+
+// Text
+//
+// A single character is a code, 32 to 127 for ASCII, 0xa0 on for Latin-1. 
+// Strings (ndotm_cmd_message, ndotm_cmd_playlist_store) are UTF-8, turned
+// into Latin-1 as they arrive. Characters past Latin-1 become 
+// NDOTM_CHAR_REPLACEMENT. A byte that doesn't start a UTF-8 sequence is 
+// taken as is, so glyph codes still work in strings. Anything the board 
+// has no picture for shows as an empty box.
+// Past 32 characters (NDOTM_MSGLEN), a string is cut short and the rest
+// dropped up to its 0.
+#define NDOTM_CHAR_REPLACEMENT 0x80
+
+// Canvas
+//
+//   ndotm_cmd_canvas <width> <first col> <col> ... <col>
+//   ndotm_cmd_view   <col> <row>
+//   ndotm_cmd_pan    <cols, -128 to 127> <rows>
+//   ndotm_cmd_drift  <cols, -128 to 127> <rows>
+//
+// The board keeps a picture up to NDOTM_CANVAS_MAXW columns wide, in 
+// ndotm_cmd_data order, and shows the part of it at the view. Moving the
+// view costs the same however wide the picture is, and the picture wraps 
+// round at the edges, both ways. Row 0 is the top. ndotm_cmd_drift moves 
+// the view every scroll step (ndotm_cmd_rate), until 0, 0.
+//
+// ndotm_cmd_canvas is followed by columns <first col> to <width> - 1, taken 
+// as is. A first col of 0 starts a new picture, with the view at 0, 0 and 
+// no drift. Anything else adds to the one there, so a picture can be sent
+// a piece at a time, in packets. Most other display commands replace it.
+#define NDOTM_CANVAS_MAXW 64
+
+// Scroll direction
+//
+//   ndotm_cmd_scroll_dir <ndotm_scroll_>
+//
+// Messages go by sideways, or roll up or down a character at a time. 
+// ndotm_cmd_dwell and ndotm_cmd_rate work the same each way. 
+enum ndotm_scroll_dir {
+  ndotm_scroll_left = 0, // the usual marquee
+  ndotm_scroll_up,       // next character comes in from the bottom
+  ndotm_scroll_down,     // next character comes in from the top
+};
+
+// Transition effects
+//
+//   ndotm_cmd_transition_fx <ndotm_fx_> <scroll ticks a step>
+//
+// Instead of going dark for ndotm_cmd_transition ticks, new characters and 
+// whole ndotm_cmd_data frames come in over the old one in 8 steps. The
+// board works out every step itself, so the master still sends one frame.
+// Left, right, up and down are the way text scrolls, flipped or not, and
+// the way data was sent.
+// ndotm_fx_cut puts back the plain ndotm_cmd_transition behaviour. Boards
+// built for panels other than 5x7 only do ndotm_fx_cut.
+enum ndotm_fx {
+  ndotm_fx_cut = 0,     // dark a while, then the new frame
+  ndotm_fx_wipe_left,   // new frame drawn over the old from the right
+  ndotm_fx_wipe_right,  //  ..from the left
+  ndotm_fx_wipe_up,     //  ..from the bottom
+  ndotm_fx_wipe_down,   //  ..from the top
+  ndotm_fx_dissolve,    // a few dots at a time, scattered
+  ndotm_fx_push_left,   // new frame slides in from the right, pushing the old one out
+  ndotm_fx_push_right,  //  ..from the left
+  ndotm_fx_push_up,     //  ..from the bottom
+  ndotm_fx_push_down,   //  ..from the top
+};
+
+// Effects
+//
+//   ndotm_cmd_effect <ndotm_effect_> <setting>
+//
+// The board makes a new frame every scroll step (ndotm_cmd_rate) by itself,
+// until ndotm_effect_off or anything but frame data is shown. Effects work
+// on the frame already up, so ndotm_cmd_data and friends can start one off
+// or draw into it as it runs. Send it again to change the setting.
+enum ndotm_effect {
+  ndotm_effect_off = 0,
+  ndotm_effect_life,    // Conway's Life, wrapping round the edges. setting is
+                        // how many of 256 dots are on when it starts again
+  ndotm_effect_sparks,  // dots rising and dying. setting is the chance of a 
+                        // new one in each column, out of 256
+  ndotm_effect_meter,   // bouncing level meter. setting is the level, 0 to 7
+};
@@ -1,4 +1,6 @@
 #include "Arduino.h"
+#include <SPI.h>
+#include <avr/pgmspace.h>
 #include "NovaDotMatrixDriver.h"
 #include "NovaDotMatrixCommands.h"
 
@@ -6,17 +8,58 @@
 uint8_t get_random_graph();
 
 void NovaDotMatrixDriver::Setup(void) {
-  pinMode(clk_pin,OUTPUT);
-  pinMode(data_pin,OUTPUT);
+  if (link == LinkSPI) {
+    // SPI mode 0 is our link: clock idles low, data sampled on the rise, MSB first
+    if (!spi_hz)
+      spi_hz = NDM_SPI_DEFAULT_HZ;
+    SPI.begin();
+  } else {
+    pinMode(clk_pin,OUTPUT);
+    pinMode(data_pin,OUTPUT);
+  }
+  if (ready_line)
+    pinMode(diag_pin, INPUT);
+  frame_valid = false;
+
+  queue_head = queue_count = 0;
+  tx_len = tx_pos = 0;
+  tx_to_buf = post_pending = false;
+  frames_sent = frames_dropped = 0;
+  last_byte_us = micros();
 }
 
 
 
 void NovaDotMatrixDriver::Write(uint8_t val) {
-  // send one byte to the blinky
+  // send one byte to the blinky, and give it time to deal with it
+  WriteBits(val);
+
+  if (ready_line) {
+    unsigned long start = millis();
+    delayMicroseconds(NDM_READY_SETTLE_US);
+    while (digitalRead(diag_pin)) {
+      if (millis() - start > NDM_INTERCMD_DELAY_MS)
+        break; // stuck busy. no worse than the fixed delay
+    }
+    return;
+  }
+
+  delay(NDM_INTERCMD_DELAY_MS);
+}
+
+void NovaDotMatrixDriver::WriteBits(uint8_t val) {
+  // clock one byte out
 
   uint8_t i,bitmask;
 
+  if (link == LinkSPI) {
+    // the hardware does it, and interrupts carry on
+    SPI.beginTransaction(SPISettings(spi_hz, MSBFIRST, SPI_MODE0));
+    SPI.transfer(val);
+    SPI.endTransaction();
+    return;
+  }
+
   bitmask = 0b10000000; // starting with the MSB
   noInterrupts();
   for ( i = 0; i < 8  ; i++ )
@@ -39,8 +82,6 @@ void NovaDotMatrixDriver::Write(uint8_t val) {
   digitalWrite(data_pin,0);
   interrupts();
 
-  delay(NDM_INTERCMD_DELAY_MS);
-
 }
 
 
@@ -50,3 +91,448 @@ void NovaDotMatrixDriver::WriteBuf(uint8_t *buf, uint8_t len) {
   }
 }
 
+
+void NovaDotMatrixDriver::WritePacket(uint8_t *body, uint8_t len) {
+  // wrap commands up with a length and crc. See NovaDotMatrixCommands.h
+  uint8_t crc;
+
+  Write(ndotm_cmd_escape_code);
+  Write(ndotm_cmd_packet);
+  Write(len);
+  crc = ndotm_crc8(0, len);
+  while(len--) {
+    crc = ndotm_crc8(crc, *body);
+    Write(*body++);
+  }
+  Write(crc);
+}
+
+void NovaDotMatrixDriver::WriteCmd2(uint8_t cmd, uint8_t p0, uint8_t p1) {
+  // a command with two parameter bytes
+  Put(ndotm_cmd_escape_code);
+  Put(cmd);
+  Put(p0);
+  Put(p1);
+}
+
+void NovaDotMatrixDriver::Put(uint8_t val) {
+  // WriteFrame() output goes on the wire, or into tx[] for Poll()
+  if (tx_to_buf)
+    tx[tx_len++] = val;
+  else
+    Write(val);
+}
+
+void NovaDotMatrixDriver::PutBuf(uint8_t *buf, uint8_t len) {
+  while(len--) {
+    Put(*buf++);
+  }
+}
+
+bool NovaDotMatrixDriver::Queue(uint8_t *buf, uint8_t len) {
+  // whole commands only, so a frame never lands in the middle of one
+  if (len > NDM_QUEUE_LEN - queue_count)
+    return false;
+  while(len--) {
+    queue[(queue_head + queue_count++) % NDM_QUEUE_LEN] = *buf++;
+  }
+  // it may change the display behind frame[]'s back, so the next frame
+  // goes out whole
+  ForgetFrame();
+  return true;
+}
+
+void NovaDotMatrixDriver::PostFrame(uint8_t *dat) {
+  // newest frame wins. one that never started going out is just replaced
+  if (post_pending)
+    frames_dropped++;
+  memcpy(post, dat, NDM_NUMCOLS);
+  post_pending = true;
+}
+
+bool NovaDotMatrixDriver::LinkClear(void) {
+  // has the board had time for the last byte?
+  unsigned long since = micros() - last_byte_us;
+
+  if (ready_line) {
+    if (since < NDM_READY_SETTLE_US)
+      return false;
+    if (!digitalRead(diag_pin))
+      return true;
+  }
+  return since >= NDM_INTERCMD_DELAY_MS * 1000UL;
+}
+
+bool NovaDotMatrixDriver::Poll(void) {
+  //
+  // Send at most one byte and return without waiting. In order of priority:
+  // the rest of a frame already started, queued commands, the posted frame.
+  // Returns true while there is anything left to do.
+  //
+  uint8_t val;
+
+  if (tx_pos == tx_len && !queue_count && !post_pending)
+    return false;
+  if (!LinkClear())
+    return true;
+
+  if (tx_pos == tx_len) {
+    tx_pos = tx_len = 0;
+    if (queue_count) {
+      val = queue[queue_head];
+      queue_head = (queue_head + 1) % NDM_QUEUE_LEN;
+      queue_count--;
+      WriteBits(val);
+      last_byte_us = micros();
+      return true;
+    }
+
+    post_pending = false;
+    tx_to_buf = true;
+    WriteFrame(post);
+    tx_to_buf = false;
+    if (!tx_len)
+      return false; // nothing changed
+    frames_sent++;
+  }
+
+  WriteBits(tx[tx_pos++]);
+  last_byte_us = micros();
+  return true;
+}
+
+void NovaDotMatrixDriver::ForgetFrame(void) {
+  // next WriteFrame() sends everything
+  frame_valid = false;
+}
+
+void NovaDotMatrixDriver::SliceCanvas(const uint8_t *canvas, uint16_t stride,
+    uint16_t x, uint16_t y, uint8_t *dat) {
+  //
+  // canvas is 1 bit per pixel, row by row, stride bytes a row, msb of each 
+  // byte the leftmost pixel. Take the 5x7 block whose top left is at x,y 
+  // and turn it into columns for ndotm_cmd_data: dat[0] the left column, 
+  // bit 6 the top row. Keeping a wall in one canvas means each board is
+  // just a different x,y.
+  //
+  // A whole row of the block comes out of at most two canvas bytes, so 
+  // it's a byte at a time, then rows shifted in to the columns.
+  //
+  const uint8_t *p = canvas + y * stride + (x >> 3);
+  uint8_t shift = x & 0b00000111;
+  uint8_t r, c, bits;
+#if NDM_SLICE_WORDS
+  uint64_t m = 0, t;
+#else
+
+  for (c = 0; c < NDM_NUMCOLS; c++)
+    dat[c] = 0;
+#endif
+
+  for (r = 0; r < NDM_NUMROWS; r++) {
+    bits = p[0] << shift;
+    if (shift > 8 - NDM_NUMCOLS)
+      bits |= p[1] >> (8 - shift); // row straddles two bytes
+    p += stride;
+
+#if NDM_SLICE_WORDS
+    // a byte of the word each, bottom row lowest
+    m |= (uint64_t)bits << (8 * (NDM_NUMROWS - 1 - r));
+#else
+    // top 5 bits are this row, left to right
+    for (c = 0; c < NDM_NUMCOLS; c++) {
+      dat[c] = (dat[c] << 1) | (bits >> 7);
+      bits <<= 1;
+    }
+#endif
+  }
+
+#if NDM_SLICE_WORDS
+  // transpose the 8x8 bits so each byte is a column. Hacker's Delight 7-3
+  t = (m ^ (m >> 7)) & 0x00aa00aa00aa00aaULL;
+  m = m ^ t ^ (t << 7);
+  t = (m ^ (m >> 14)) & 0x0000cccc0000ccccULL;
+  m = m ^ t ^ (t << 14);
+  t = (m ^ (m >> 28)) & 0x00000000f0f0f0f0ULL;
+  m = m ^ t ^ (t << 28);
+  for (c = 0; c < NDM_NUMCOLS; c++)
+    dat[c] = (uint8_t)(m >> (8 * (7 - c))); // the msb was the leftmost column
+#endif
+}
+
+uint8_t NovaDotMatrixDriver::WriteFrame(uint8_t *dat) {
+  //
+  // Bring the board from frame[] to dat[] with as few bytes as we can.
+  // dat[] is in the same column order as ndotm_cmd_data.
+  //
+  // Candidates are:
+  //   the whole frame                       2 + 5 bytes
+  //   one ndotm_cmd_cols over the changes   3 + n bytes
+  //   ndotm_cmd_data_scroll, when it's the
+  //   last frame moved along one column     3 bytes
+  //   one ndotm_cmd_pixels per distinct
+  //   column change                         4 bytes each
+  //
+  // A parameter byte equal to ndotm_cmd_escape_code would wreck the framing,
+  // so any candidate carrying one is ruled out. The pixel ops can always
+  // get there.
+  //
+  // Returns the number of bytes sent.
+  //
+  uint8_t diff[NDM_NUMCOLS];
+  uint8_t i, j, first, last, changed, groups, cost, sent;
+  bool full_ok, range_ok;
+
+  sent = 0;
+  full_ok = true;
+  for (i = 0; i < NDM_NUMCOLS; i++) {
+    if (dat[i] == ndotm_cmd_escape_code)
+      full_ok = false;
+  }
+
+  if (!frame_valid) {
+    if (full_ok) {
+      Put(ndotm_cmd_escape_code);
+      Put(ndotm_cmd_data);
+      PutBuf(dat, NDM_NUMCOLS);
+      memcpy(frame, dat, NDM_NUMCOLS);
+      frame_valid = true;
+      return NDM_FULL_FRAME_BYTES;
+    }
+    // don't know what's there, so blank it and build up from nothing
+    WriteCmd2(ndotm_cmd_pixels, ndotm_pix_clear | NDOTM_PIX_COL_MASK, 0b01111111);
+    sent += 4;
+    memset(frame, 0, NDM_NUMCOLS);
+    frame_valid = true;
+  }
+
+  changed = groups = 0;
+  first = last = 0;
+  range_ok = true;
+  for (i = 0; i < NDM_NUMCOLS; i++) {
+    diff[i] = frame[i] ^ dat[i];
+    if (!diff[i])
+      continue;
+    if (!changed++)
+      first = i;
+    last = i;
+
+    // count distinct column changes, splitting any that look like an escape
+    for (j = 0; j < i; j++) {
+      if (diff[j] == diff[i])
+        break;
+    }
+    if (j == i)
+      groups += (diff[i] == ndotm_cmd_escape_code) ? 2 : 1;
+  }
+
+  if (!changed)
+    return sent;
+
+  // scrolled along one, with a new column coming in at the end?
+  // only the sideways shift_dirs, which don't touch the column bits
+  j = NDM_NUMCOLS;
+  if (shift_dir == 0 && !memcmp(dat, frame + 1, NDM_NUMCOLS - 1))
+    j = NDM_NUMCOLS - 1; // in on the right
+  else if (shift_dir == 1 && !memcmp(dat + 1, frame, NDM_NUMCOLS - 1))
+    j = 0;               // in on the left
+  if (j < NDM_NUMCOLS && dat[j] != ndotm_cmd_escape_code) {
+    Put(ndotm_cmd_escape_code);
+    Put(ndotm_cmd_data_scroll);
+    Put(dat[j]);
+    memcpy(frame, dat, NDM_NUMCOLS);
+    return sent + 3;
+  }
+
+  for (i = first; i <= last; i++) {
+    if (dat[i] == ndotm_cmd_escape_code)
+      range_ok = false;
+  }
+
+  cost = groups * 4;
+  if (range_ok && (3 + last - first + 1) < cost)
+    cost = 3 + last - first + 1;
+
+  if (full_ok && NDM_FULL_FRAME_BYTES < cost) {
+    cost = NDM_FULL_FRAME_BYTES;
+    Put(ndotm_cmd_escape_code);
+    Put(ndotm_cmd_data);
+    PutBuf(dat, NDM_NUMCOLS);
+  } else if (range_ok && cost == 3 + last - first + 1) {
+    if (first == last) {
+      WriteCmd2(ndotm_cmd_col, first, dat[first]);
+    } else {
+      Put(ndotm_cmd_escape_code);
+      Put(ndotm_cmd_cols);
+      Put(((last - first + 1) << 4) | first);
+      PutBuf(dat + first, last - first + 1);
+    }
+  } else {
+    // one pixel op per distinct change
+    for (i = first; i <= last; i++) {
+      uint8_t colmask, op, on, off;
+
+      if (!diff[i])
+        continue;
+
+      colmask = on = off = 0;
+      for (j = i; j <= last; j++) {
+        if (diff[j] != diff[i])
+          continue;
+        colmask |= (1 << j);
+        on  |= dat[j] & diff[i];
+        off |= ~dat[j] & diff[i];
+      }
+
+      // set or clear are more forgiving than toggle if we ever get out of step
+      if (!off)
+        op = ndotm_pix_set;
+      else if (!on)
+        op = ndotm_pix_clear;
+      else
+        op = ndotm_pix_toggle;
+
+      if (diff[i] == ndotm_cmd_escape_code) {
+        WriteCmd2(ndotm_cmd_pixels, op | colmask, diff[i] & 0b01110000);
+        WriteCmd2(ndotm_cmd_pixels, op | colmask, diff[i] & 0b00001111);
+      } else {
+        WriteCmd2(ndotm_cmd_pixels, op | colmask, diff[i]);
+      }
+
+      for (j = i + 1; j <= last; j++) {
+        if (diff[j] == diff[i])
+          diff[j] = 0; // taken care of
+      }
+    }
+  }
+
+  memcpy(frame, dat, NDM_NUMCOLS);
+  return sent + cost;
+}
+
+uint32_t NovaDotMatrixDriver::WireMicros(uint32_t bytes) {
+  // clocking plus the gap after each byte
+  uint32_t per_byte = NDM_INTERCMD_DELAY_MS * 1000UL;
+
+  if (link == LinkSPI)
+    per_byte += 8000000UL / (spi_hz ? spi_hz : NDM_SPI_DEFAULT_HZ);
+  else
+    per_byte += 16UL * NDM_HALF_BIT_PERIOD_US;
+  return per_byte * bytes;
+}
+
+uint16_t NovaDotMatrixDriver::StreamWord(uint16_t off) {
+  return pgm_read_byte(stream + off) | (pgm_read_byte(stream + off + 1) << 8);
+}
+
+uint32_t NovaDotMatrixDriver::StreamTime(uint16_t entry) {
+  uint16_t off = NDM_STREAM_HEADER_LEN + entry * NDM_STREAM_ENTRY_LEN;
+  return StreamWord(off) | ((uint32_t)StreamWord(off + 2) << 16);
+}
+
+bool NovaDotMatrixDriver::StreamStart(const uint8_t *s, uint8_t panel) {
+  if (pgm_read_byte(s) != 'N' || pgm_read_byte(s + 1) != 'D' || 
+      pgm_read_byte(s + 2) != 'S' || pgm_read_byte(s + 3) != NDM_STREAM_VERSION)
+    return false;
+
+  stream         = s;
+  stream_panel   = panel;
+  stream_entries = StreamWord(4);
+  stream_next    = 0;
+  return true;
+}
+
+void NovaDotMatrixDriver::StreamSeek(uint32_t ms) {
+  // binary search the index
+  uint16_t lo = 0, hi = stream_entries, mid;
+
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (StreamTime(mid) < ms)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  stream_next = lo;
+}
+
+bool NovaDotMatrixDriver::StreamPlay(uint32_t ms) {
+  //
+  // Call with the time since the stream started. Whatever's due for our 
+  // panel goes out with Write(), a byte at a time from PROGMEM.
+  //
+  uint16_t entry, off, end;
+  uint8_t panel;
+
+  while (stream_next < stream_entries && StreamTime(stream_next) <= ms) {
+    entry = NDM_STREAM_HEADER_LEN + stream_next * NDM_STREAM_ENTRY_LEN;
+    panel = pgm_read_byte(stream + entry + 4);
+    off   = StreamWord(entry + 5);
+    if (++stream_next < stream_entries)
+      end = StreamWord(entry + NDM_STREAM_ENTRY_LEN + 5);
+    else
+      end = StreamWord(6);
+
+    if (panel != stream_panel && panel != NDM_STREAM_ALL_PANELS)
+      continue;
+    for (; off < end; off++)
+      Write(pgm_read_byte(stream + off));
+  }
+  return stream_next < stream_entries;
+}
+
+uint8_t NovaDotMatrixDriver::Diag(uint8_t what, uint8_t *buf, uint8_t len) {
+  // the board starts answering as soon as it has the last byte, so no 
+  // waiting around after it
+  Write(ndotm_cmd_escape_code);
+  Write(ndotm_cmd_diag);
+  WriteBits(what);
+  return ReadDiag(buf, len);
+}
+
+uint8_t NovaDotMatrixDriver::ReadDiag(uint8_t *buf, uint8_t len) {
+  //
+  // 8N1 async serial from the board's data out pin. 
+  // That pin blanks the display too, so first wait for it to sit high
+  // for a good part of the preamble.
+  //
+  unsigned long start, high_since;
+  uint8_t n, i, c;
+
+  pinMode(diag_pin, INPUT);
+
+  start = millis();
+  high_since = micros();
+  while (micros() - high_since < (NDOTM_DIAG_PREAMBLE_BITS / 2) * NDOTM_DIAG_BIT_US) {
+    if (!digitalRead(diag_pin))
+      high_since = micros();
+    if (millis() - start > NDM_DIAG_TIMEOUT_MS)
+      return 0;
+  }
+
+  for (n = 0; n < len; n++) {
+    // wait for start bit
+    while (digitalRead(diag_pin)) {
+      if (millis() - start > NDM_DIAG_TIMEOUT_MS)
+        return n;
+    }
+
+    noInterrupts();
+    delayMicroseconds(NDOTM_DIAG_BIT_US + NDOTM_DIAG_BIT_US / 2); // middle of first data bit
+    c = 0;
+    for (i = 0; i < 8; i++) {
+      c = c >> 1;
+      if (digitalRead(diag_pin))
+        c |= 0b10000000;
+      delayMicroseconds(NDOTM_DIAG_BIT_US);
+    }
+    interrupts();
+
+    buf[n] = c; // we are in the stop bit now
+    start = millis(); // a long answer can take longer than the timeout, so it's per byte
+  }
+  // the board has its interrupts off until the stop bit is out, and
+  // would miss the clock on whatever we send next
+  delayMicroseconds(NDOTM_DIAG_BIT_US);
+  return n;
+}
@@ -1,13 +1,143 @@
+#ifndef NovaDotMatrixDriver_h
+#define NovaDotMatrixDriver_h
 
 #define NDM_INTERCMD_DELAY_MS 5
 #define NDM_HALF_BIT_PERIOD_US 150
 #define NDM_DEMO_DURATION_MS 5000
+#define NDM_DIAG_TIMEOUT_MS 50
+#define NDM_SPI_DEFAULT_HZ 125000 // slowest SPI clock on a 16MHz AVR
+#define NDM_READY_SETTLE_US 50    // give the board's ISR time to say busy
+
+#define NDM_NUMCOLS 5
+#define NDM_NUMROWS 7
+#define NDM_QUEUE_LEN 32 // bytes of commands Queue() can hold
+#define NDM_TX_LEN    28 // most WriteFrame() can send: blank, then 6 pixel ops
+#define NDM_FULL_FRAME_BYTES (2 + NDM_NUMCOLS) // escape, ndotm_cmd_data, columns
+
+// SliceCanvas() a 64 bit word at a time, with a bit matrix transpose. 
+// About twice as fast on a 64 bit host, far slower on an 8 bit AVR. 
+// Define as 1 to try it on a 32 bit board
+#ifndef NDM_SLICE_WORDS
+#if UINTPTR_MAX > 0xffffffff
+#define NDM_SLICE_WORDS 1
+#else
+#define NDM_SLICE_WORDS 0
+#endif
+#endif
+
+//
+// Command streams
+//
+// A stream is a byte array in PROGMEM of commands to send at set times, 
+// for one board or a whole wall of them. Numbers are little endian.
+//
+//   'N' 'D' 'S' NDM_STREAM_VERSION
+//   number of entries                              2 bytes
+//   offset of the end of the commands              2 bytes
+//   index, one per entry, in time order:
+//     ms from the start                            4 bytes
+//     panel, or NDM_STREAM_ALL_PANELS              1 byte
+//     offset of its commands from the stream start 2 bytes
+//   commands
+//
+// An entry's commands run up to where the next entry's start. Use the 
+// NDM_STREAM_ macros to lay one out in a sketch.
+//
+// Past 64KB, a stream is NDM_STREAM_VERSION_WIDE: the same, but with 4
+// bytes for the number of entries and 8 for the end and each offset.
+// Only a host reads those, from a file (tools/NdmStreamFile.h).
+//
+#define NDM_STREAM_VERSION    1
+#define NDM_STREAM_HEADER_LEN 8
+#define NDM_STREAM_ENTRY_LEN  7
+#define NDM_STREAM_ALL_PANELS 0xff
+
+#define NDM_STREAM_VERSION_WIDE    2
+#define NDM_STREAM_WIDE_HEADER_LEN 16
+#define NDM_STREAM_WIDE_ENTRY_LEN  13
+
+#define NDM_U16(x) (uint8_t)(x), (uint8_t)((x) >> 8)
+#define NDM_U32(x) NDM_U16(x), NDM_U16((uint32_t)(x) >> 16)
+#define NDM_STREAM_HEADER(entries, end) 'N', 'D', 'S', NDM_STREAM_VERSION, NDM_U16(entries), NDM_U16(end)
+#define NDM_STREAM_ENTRY(ms, panel, offset) NDM_U32(ms), (panel), NDM_U16(offset)
+#define NDM_STREAM_COMMANDS(entries) (NDM_STREAM_HEADER_LEN + (entries) * NDM_STREAM_ENTRY_LEN) // offset of the first command
 
 class NovaDotMatrixDriver {
   public:
     uint8_t clk_pin,data_pin;
+    uint8_t diag_pin; // wired to the board's data out, if you want diagnostics
+
+    // how bytes get clocked out. Set before Setup()
+    uint8_t link;
+    enum link {
+      LinkBitBang = 0, // clk_pin, data_pin, NDM_HALF_BIT_PERIOD_US
+      LinkSPI,         // SCK and MOSI instead. board needs NDOTM_RX_USI
+    };
+    uint32_t spi_hz;   // SPI clock for LinkSPI. 0 for NDM_SPI_DEFAULT_HZ
+
+    // board built with NDOTM_READY_LINE: wait on diag_pin going low after 
+    // each byte instead of NDM_INTERCMD_DELAY_MS, which becomes the timeout
+    bool ready_line;
     void Setup(void);
     void Write(uint8_t );
     void WriteBuf(uint8_t *, uint8_t ); 
+    void WritePacket(uint8_t *, uint8_t ); // body of packed commands
+
+    // send only what changed since the last WriteFrame()
+    uint8_t WriteFrame(uint8_t *);
+    void ForgetFrame(void); // call after anything else changes the display
+    uint8_t shift_dir;      // board's ndotm_cmd_shift_dir, 0 after reset. keep it in step
+
+    // about how long that many bytes take with the blocking calls, in usec.
+    // with ready_line, the most they can take
+    uint32_t WireMicros(uint32_t);
+
+    // cut one board's frame out of a bigger picture, ready for WriteFrame()
+    void SliceCanvas(const uint8_t *, uint16_t, uint16_t, uint16_t, uint8_t *);
+
+    // Without blocking: Queue() whole commands and PostFrame() frames, then
+    // call Poll() often. Commands go out in order and ahead of frames. A 
+    // posted frame that hasn't started going out is replaced by the next 
+    // one. Don't mix with the Write...() calls while Poll() is busy.
+    bool Queue(uint8_t *, uint8_t); // false, and nothing queued, if it won't fit
+    void PostFrame(uint8_t *);
+    bool Poll(void);                // true while there's more to send
+    uint16_t frames_sent, frames_dropped; // sent: ones that changed something
+
+    // play a command stream (see above) straight out of PROGMEM
+    bool StreamStart(const uint8_t *, uint8_t); // stream, our panel. false if it isn't one
+    void StreamSeek(uint32_t);                  // next to play is the first at or after ms
+    bool StreamPlay(uint32_t);                  // send everything due by ms. false when done
+
+    // ask for ndotm_diag_*, and collect the answer. returns bytes received
+    uint8_t Diag(uint8_t, uint8_t *, uint8_t);
+
+  private:
+    void WriteBits(uint8_t);
+    uint8_t ReadDiag(uint8_t *, uint8_t);
+    uint8_t frame[NDM_NUMCOLS]; // what we think the board is showing
+    bool frame_valid;
+    void WriteCmd2(uint8_t, uint8_t, uint8_t);
+    void Put(uint8_t);
+    void PutBuf(uint8_t *, uint8_t);
+
+    // for Poll()
+    bool LinkClear(void);
+    uint8_t queue[NDM_QUEUE_LEN];
+    uint8_t queue_head, queue_count;
+    uint8_t tx[NDM_TX_LEN]; // frame on its way out
+    uint8_t tx_len, tx_pos;
+    bool tx_to_buf;         // Put() into tx[] instead of Write()
+    uint8_t post[NDM_NUMCOLS];
+    bool post_pending;
+    unsigned long last_byte_us;
+
+    // for Stream...()
+    const uint8_t *stream;
+    uint16_t stream_entries, stream_next;
+    uint8_t stream_panel;
+    uint16_t StreamWord(uint16_t);
+    uint32_t StreamTime(uint16_t);
 };
 
+#endif // NovaDotMatrixDriver_h
@@ -0,0 +1,112 @@
+/*
+ * Ask a Nova SMT Blinky LED dot matrix board how it is doing
+ *
+ * Wire the board's data out (the blanking pin, PB1) to diag_pin
+ * as well as the usual clock and data.
+ */
+
+#include "Arduino.h"
+#include <NovaDotMatrixCommands.h>
+#include <NovaDotMatrixDriver.h>
+
+NovaDotMatrixDriver novadotmatrixdriver;
+
+#define BOARD_MHZ 8 // the blinky's clock, to turn Timer0 counts into usec
+
+// in ndotm_prof_site order
+const char *site_names[ndotm_prof_max] = {
+  "WriteCol",
+  "WriteNextCol",
+  "ProcessInData",
+  "ScrollAndDwell",
+  "DemoManage",
+  "ISR PCINT0/USI_OVF",
+  "ISR TIMER1_OVF",
+  "EffectStep",
+};
+
+// Timer0 prescale for each clock select
+const uint16_t prescale[8] = { 0, 1, 8, 64, 256, 1024, 0, 0 };
+
+void print_usec(uint32_t counts, uint16_t usec_per_count_x8) {
+  // usec, to 1/8th
+  uint32_t x8 = counts * usec_per_count_x8;
+  Serial.print(x8 / 8,DEC);
+  Serial.print(".");
+  Serial.print((x8 % 8) * 125,DEC);
+  Serial.print("\t");
+}
+
+void print_profile(uint8_t *dat) {
+  // pretty print a ndotm_diag_profile answer
+  uint16_t usec_per_count_x8 = prescale[dat[2] & 0b00000111] * 8 / BOARD_MHZ;
+  uint8_t *p;
+
+  if (!dat[1]) {
+    Serial.println("Profile: board not built with NDOTM_PROFILE");
+    return;
+  }
+
+  Serial.println("Profile (usec)");
+  Serial.println("site\t\tcalls\tmin\tmax\tavg");
+  for (uint8_t i = 0; i < dat[1] && i < ndotm_prof_max; i++) {
+    uint16_t calls;
+    uint32_t total;
+
+    p = dat + 3 + i * NDOTM_DIAG_PROFILE_SITE_LEN;
+    calls = p[0] | (p[1] << 8);
+    total = p[4] | ((uint32_t)p[5] << 8) | ((uint32_t)p[6] << 16) | ((uint32_t)p[7] << 24);
+
+    Serial.print(site_names[i]);
+    Serial.print(strlen(site_names[i]) < 8 ? "\t\t" : "\t");
+    Serial.print(calls,DEC);
+    Serial.print("\t");
+    if (!calls) {
+      Serial.println("-");
+      continue;
+    }
+    print_usec(p[2], usec_per_count_x8);
+    print_usec(p[3], usec_per_count_x8);
+    print_usec(total / calls, usec_per_count_x8);
+    Serial.println();
+  }
+}
+
+void setup() {
+    novadotmatrixdriver.clk_pin = 7; // select clock pin
+    novadotmatrixdriver.data_pin = 8; // select data pin
+    novadotmatrixdriver.diag_pin = 9; // select diagnostics pin
+    novadotmatrixdriver.Setup();
+
+    Serial.begin(9600); // tell outside world what we are doing
+    Serial.println("Diagnostics start");
+}
+
+void loop() {
+  uint8_t dat[NDOTM_DIAG_PROFILE_LEN];
+
+  // 
+  // timer: did the board fall behind?
+  //
+  if (novadotmatrixdriver.Diag(ndotm_diag_timer, dat, NDOTM_DIAG_TIMER_LEN) == NDOTM_DIAG_TIMER_LEN &&
+      dat[0] == ndotm_diag_timer) {
+    Serial.print("Timer: max backlog ");  Serial.print(dat[1],DEC);
+    Serial.print(" ticks, late ");        Serial.print(dat[2] | (dat[3] << 8),DEC);
+    Serial.print(" ticks, overflowed ");  Serial.print(dat[4],DEC);
+    Serial.println(" times");
+  } else {
+    Serial.println("Timer: no answer");
+  }
+
+  // 
+  // profile: where is the time going? start over each time
+  //
+  if (novadotmatrixdriver.Diag(ndotm_diag_profile | NDOTM_DIAG_CLEAR, dat, NDOTM_DIAG_PROFILE_LEN) >= 3 &&
+      dat[0] == ndotm_diag_profile) {
+    print_profile(dat);
+  } else {
+    Serial.println("Profile: no answer");
+  }
+
+  delay(1000);
+}
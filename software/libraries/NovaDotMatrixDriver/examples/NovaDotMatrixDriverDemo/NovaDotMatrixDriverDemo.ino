@@ -8,6 +8,37 @@
 
 NovaDotMatrixDriver novadotmatrixdriver;
 
+// for the canvas demo. 1 bit a pixel, msb on the left
+#define CANVAS_WIDTH  15
+#define CANVAS_STRIDE 2
+const uint8_t canvas[NDM_NUMROWS * CANVAS_STRIDE] = {
+  0b01110010, 0b00111000,
+  0b10001010, 0b01000100,
+  0b10001010, 0b10000010,
+  0b11111010, 0b10000010,
+  0b10001010, 0b10000010,
+  0b10001010, 0b01000100,
+  0b10001011, 0b11111000,
+};
+
+// for the glyph demo. columns left to right, lsb the top row
+const uint8_t heart[NDM_NUMCOLS] = { 0x0e, 0x1f, 0x3e, 0x1f, 0x0e };
+
+// for the stream demo. a face that winks, every panel
+#define WINK_ENTRIES 4
+#define WINK_FRAME(a,b,c,d,e) ndotm_cmd_escape_code, ndotm_cmd_data, a, b, c, d, e
+const uint8_t wink_stream[] PROGMEM = {
+  NDM_STREAM_HEADER(WINK_ENTRIES, NDM_STREAM_COMMANDS(WINK_ENTRIES) + 4 * 7),
+  NDM_STREAM_ENTRY(   0, NDM_STREAM_ALL_PANELS, NDM_STREAM_COMMANDS(WINK_ENTRIES) + 0 * 7),
+  NDM_STREAM_ENTRY(1200, NDM_STREAM_ALL_PANELS, NDM_STREAM_COMMANDS(WINK_ENTRIES) + 1 * 7),
+  NDM_STREAM_ENTRY(1500, NDM_STREAM_ALL_PANELS, NDM_STREAM_COMMANDS(WINK_ENTRIES) + 2 * 7),
+  NDM_STREAM_ENTRY(2500, NDM_STREAM_ALL_PANELS, NDM_STREAM_COMMANDS(WINK_ENTRIES) + 3 * 7),
+  WINK_FRAME(0b0000100, 0b0110010, 0b0000010, 0b0110010, 0b0000100),
+  WINK_FRAME(0b0000100, 0b0110010, 0b0000010, 0b0010010, 0b0000100),
+  WINK_FRAME(0b0000100, 0b0110010, 0b0000010, 0b0110010, 0b0000100),
+  WINK_FRAME(0, 0, 0, 0, 0),
+};
+
 static  unsigned long cur_ms;
 static  unsigned long last_ms;
 static  bool demo_complete;
@@ -16,6 +47,8 @@ char c;
 void setup() {
     novadotmatrixdriver.clk_pin = 7; // select clock pin
     novadotmatrixdriver.data_pin = 8; // select data pin
+    // or, for a board built with NDOTM_RX_USI, wire clock to SCK and data to MOSI and
+    // novadotmatrixdriver.link = NovaDotMatrixDriver::LinkSPI;
     novadotmatrixdriver.Setup();
 
     Serial.begin(9600); // tell outside world what we are doing
@@ -35,9 +68,9 @@ void loop() {
   //
 
 #define START_DEMO 1
-#define END_DEMO 6
+#define END_DEMO 15
 
-#define MAX_DEMO 6 // always the actual # of demos
+#define MAX_DEMO 15 // always the actual # of demos
   static uint8_t       which_demo    = START_DEMO;
   static bool          did_this_once = false;
   static unsigned long demo_duration = NDM_DEMO_DURATION_MS;
@@ -47,6 +80,8 @@ void loop() {
 
   static int8_t inner_demo_ctr       = 0; // inner counter for timing modulations within a demo
   static int8_t inner_demo_step      = 1; // they are signed so we can add/subtract
+  static unsigned long bytes_sent, bytes_full; // for delta frames
+  static unsigned long stream_start_ms;
 
 
   cur_ms = millis();
@@ -198,7 +233,7 @@ void loop() {
 
       break;
 
-    case MAX_DEMO:
+    case 6:
       // -------------------------
       if (!did_this_once) {
         Serial.println("Two Characters");
@@ -227,8 +262,260 @@ void loop() {
 
       break;
 
+    case 7:
+      // -------------------------
+      // Delta frames
+      // crawling bit and a bouncing row, sending only what changed
+      if (!did_this_once) {
+        Serial.println("Delta Frames");
+        did_this_once = true;
+        novadotmatrixdriver.ForgetFrame();
+        bytes_sent = bytes_full = 0;
+        demo_complete = false;
+        d = 0;
+        inner_demo_ctr = 0;
+        inner_demo_step = 1;
+      }
+
+      for(uint8_t i = 0; i < 5; i++) 
+        dat[i] = (1 << inner_demo_ctr);
+      dat[d / 7] ^= (1 << (d % 7));
+
+      bytes_sent += novadotmatrixdriver.WriteFrame(dat);
+      bytes_full += NDM_FULL_FRAME_BYTES;
+
+      if (++d >= 35) {
+        d = 0;
+        inner_demo_ctr += inner_demo_step;
+        if (inner_demo_ctr <= 0 || inner_demo_ctr >= 6)
+          inner_demo_step = -inner_demo_step;
+      }
+
+      if (!(d % 35) && !inner_demo_ctr) {
+        Serial.print("Sent "); Serial.print(bytes_sent,DEC);
+        Serial.print(" bytes instead of "); Serial.print(bytes_full,DEC);
+        Serial.print(", about "); Serial.print(novadotmatrixdriver.WireMicros(bytes_sent) / 1000,DEC);
+        Serial.print(" ms instead of "); Serial.print(novadotmatrixdriver.WireMicros(bytes_full) / 1000,DEC);
+        Serial.println(" ms");
+        demo_complete = true;
+      }
+      break;
+
+    case 8:
+      // -------------------------
+      // Canvas
+      // pan a window across a picture 3 boards wide
+      if (!did_this_once) {
+        Serial.println("Canvas");
+        did_this_once = true;
+        novadotmatrixdriver.ForgetFrame();
+        demo_complete = false;
+        inner_demo_ctr = 0;
+        inner_demo_step = 1;
+      }
+
+      novadotmatrixdriver.SliceCanvas(canvas, CANVAS_STRIDE, inner_demo_ctr, 0, dat);
+      novadotmatrixdriver.WriteFrame(dat);
+      delay(150);
+
+      inner_demo_ctr += inner_demo_step;
+      if (inner_demo_ctr >= CANVAS_WIDTH - NDM_NUMCOLS)
+        inner_demo_step = -1;
+      if (inner_demo_ctr <= 0) {
+        inner_demo_step = 1;
+        demo_complete = true;
+      }
+      break;
+
+    case 9:
+      // -------------------------
+      // Stream
+      // play a canned animation out of flash a few times
+      if (!did_this_once) {
+        Serial.println("Stream");
+        did_this_once = true;
+        novadotmatrixdriver.StreamStart(wink_stream, 0);
+        stream_start_ms = cur_ms;
+        demo_complete = false;
+        inner_demo_ctr = 0;
+      }
+
+      if (!novadotmatrixdriver.StreamPlay(cur_ms - stream_start_ms)) {
+        // from the top
+        novadotmatrixdriver.StreamSeek(0);
+        stream_start_ms = cur_ms;
+        if (++inner_demo_ctr >= 3)
+          demo_complete = true;
+      }
+      break;
+
+    case 10:
+      // -------------------------
+      // Counter
+      // the board keeps the count, we just say up or down
+      if (!did_this_once) {
+        Serial.println("Counter");
+        did_this_once = true;
+        novadotmatrixdriver.Write(ndotm_cmd_escape_code);
+        novadotmatrixdriver.Write(ndotm_cmd_transition);
+        novadotmatrixdriver.Write(0);
+
+        novadotmatrixdriver.Write(ndotm_cmd_escape_code);
+        novadotmatrixdriver.Write(ndotm_cmd_counter);
+        novadotmatrixdriver.Write(ndotm_counter_blank0);
+        novadotmatrixdriver.Write(0);
+        inner_demo_ctr = 0;
+        demo_complete = false;
+      }
+
+      novadotmatrixdriver.Write(ndotm_cmd_escape_code);
+      if (random(4))
+        novadotmatrixdriver.Write(ndotm_cmd_count_up);
+      else
+        novadotmatrixdriver.Write(ndotm_cmd_count_down);
+      delay(100);
+
+      if (++inner_demo_ctr >= 100)
+        demo_complete = true;
+      break;
+
+    case 11:
+      // -------------------------
+      // Glyphs
+      // draw a heart once, then use it like any other character
+      if (!did_this_once) {
+        Serial.println("Glyphs");
+        did_this_once = true;
+        novadotmatrixdriver.Write(ndotm_cmd_escape_code);
+        novadotmatrixdriver.Write(ndotm_cmd_glyph);
+        novadotmatrixdriver.Write(NDOTM_GLYPH_FIRST);
+        novadotmatrixdriver.WriteBuf((uint8_t *)heart, NDM_NUMCOLS);
+        delay(25); // it goes in eeprom
+
+        novadotmatrixdriver.Write(ndotm_cmd_escape_code);
+        novadotmatrixdriver.Write(ndotm_cmd_message);
+        novadotmatrixdriver.WriteBuf((uint8_t *)"I \x90 U ",7);
+        demo_duration = 10000;
+      }
+      delay(1000);
+      demo_complete = true;
+      break;
+
+    case 12:
+      // -------------------------
+      // Board Canvas
+      // the canvas picture goes over once. after that the board pans it
+      // by itself, and we only steer
+      if (!did_this_once) {
+        Serial.println("Board Canvas");
+        did_this_once = true;
+        novadotmatrixdriver.Write(ndotm_cmd_escape_code);
+        novadotmatrixdriver.Write(ndotm_cmd_canvas);
+        novadotmatrixdriver.Write(CANVAS_WIDTH);
+        novadotmatrixdriver.Write(0);
+        for (uint8_t x = 0; x < CANVAS_WIDTH; x += NDM_NUMCOLS) {
+          novadotmatrixdriver.SliceCanvas(canvas, CANVAS_STRIDE, x, 0, dat);
+          novadotmatrixdriver.WriteBuf(dat, NDM_NUMCOLS);
+        }
+
+        novadotmatrixdriver.Write(ndotm_cmd_escape_code);
+        novadotmatrixdriver.Write(ndotm_cmd_rate);
+        novadotmatrixdriver.Write(3);
+        inner_demo_ctr = 0;
+        demo_duration = 10000;
+      }
+
+      // across, then across and down
+      novadotmatrixdriver.Write(ndotm_cmd_escape_code);
+      novadotmatrixdriver.Write(ndotm_cmd_drift);
+      novadotmatrixdriver.Write(1);
+      novadotmatrixdriver.Write(inner_demo_ctr++ & 1);
+      delay(2500);
+      demo_complete = true;
+      break;
+
+    case 13:
+      // -------------------------
+      // Vertical Message
+      if (!did_this_once) {
+        Serial.println("Vertical Message");
+        did_this_once = true;
+        novadotmatrixdriver.Write(ndotm_cmd_escape_code);
+        novadotmatrixdriver.Write(ndotm_cmd_scroll_dir);
+        novadotmatrixdriver.Write(ndotm_scroll_up);
+
+        novadotmatrixdriver.Write(ndotm_cmd_escape_code);
+        novadotmatrixdriver.Write(ndotm_cmd_message);
+        novadotmatrixdriver.WriteBuf((uint8_t *)"UP+DOWN ",9);
+        demo_duration = 8000;
+      }
+      delay(4000);
+      novadotmatrixdriver.Write(ndotm_cmd_escape_code);
+      novadotmatrixdriver.Write(ndotm_cmd_scroll_dir);
+      novadotmatrixdriver.Write(ndotm_scroll_down);
+      demo_complete = true;
+      break;
+
+    case 14:
+      // -------------------------
+      // Transitions
+      // one frame each time, the board does the in-betweens
+      if (!did_this_once) {
+        Serial.println("Transitions");
+        did_this_once = true;
+        d = ndotm_fx_wipe_left;
+        demo_duration = 20000;
+      }
+      novadotmatrixdriver.Write(ndotm_cmd_escape_code);
+      novadotmatrixdriver.Write(ndotm_cmd_transition_fx);
+      novadotmatrixdriver.Write(d);
+      novadotmatrixdriver.Write(2);
+
+      // a whole ndotm_cmd_data frame, not WriteFrame()'s changes, sets it off
+      novadotmatrixdriver.SliceCanvas(canvas, CANVAS_STRIDE, (d & 1) ? 0 : 10, 0, dat);
+      novadotmatrixdriver.Write(ndotm_cmd_escape_code);
+      novadotmatrixdriver.Write(ndotm_cmd_data);
+      novadotmatrixdriver.WriteBuf(dat, NDM_NUMCOLS);
+      if (++d > ndotm_fx_push_down)
+        d = ndotm_fx_wipe_left;
+      delay(1500);
+      demo_complete = true;
+      break;
+
+    case MAX_DEMO:
+      // -------------------------
+      // Effects
+      // a command now and then, the board does all the drawing
+      if (!did_this_once) {
+        Serial.println("Effects");
+        did_this_once = true;
+        novadotmatrixdriver.Write(ndotm_cmd_escape_code);
+        novadotmatrixdriver.Write(ndotm_cmd_rate);
+        novadotmatrixdriver.Write(4);
 
+        novadotmatrixdriver.Write(ndotm_cmd_escape_code);
+        novadotmatrixdriver.Write(ndotm_cmd_effect);
+        novadotmatrixdriver.Write(ndotm_effect_life);
+        novadotmatrixdriver.Write(0);
+        inner_demo_ctr = 0;
+        demo_duration = 24000;
+      }
 
+      if (++inner_demo_ctr == 16) {
+        novadotmatrixdriver.Write(ndotm_cmd_escape_code);
+        novadotmatrixdriver.Write(ndotm_cmd_effect);
+        novadotmatrixdriver.Write(ndotm_effect_sparks);
+        novadotmatrixdriver.Write(90);
+      } else if (inner_demo_ctr > 32) {
+        // the meter follows something that sounds like music
+        novadotmatrixdriver.Write(ndotm_cmd_escape_code);
+        novadotmatrixdriver.Write(ndotm_cmd_effect);
+        novadotmatrixdriver.Write(ndotm_effect_meter);
+        novadotmatrixdriver.Write(random(NDM_NUMROWS + 1));
+      }
+      delay(500);
+      demo_complete = true;
+      break;
 
     default:
       break;
@@ -242,6 +529,7 @@ void loop() {
     Serial.print("Reset...");
     novadotmatrixdriver.Write(ndotm_cmd_escape_code);
     novadotmatrixdriver.Write(ndotm_cmd_reset);
+    novadotmatrixdriver.ForgetFrame();
 
     // Periodically change to next demo
     last_ms = cur_ms;
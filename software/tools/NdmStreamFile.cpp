@@ -0,0 +1,133 @@
+/*
+  Command streams from a file. See NdmStreamFile.h
+*/
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "NdmStreamFile.h"
+
+static uint64_t Le(const uint8_t *p, uint8_t len) {
+  // little endian, len bytes
+  uint64_t v = 0;
+
+  while (len--)
+    v = (v << 8) | p[len];
+  return v;
+}
+
+NdmStreamFile::NdmStreamFile(void) {
+  map = 0;
+  size = entries = next = end = 0;
+}
+
+NdmStreamFile::~NdmStreamFile(void) {
+  Close();
+}
+
+bool NdmStreamFile::Open(const char *path) {
+  struct stat st;
+  uint64_t index_end;
+  void *m;
+  int fd;
+
+  Close();
+  if ((fd = open(path, O_RDONLY)) < 0)
+    return false;
+  if (fstat(fd, &st) || st.st_size < NDM_STREAM_HEADER_LEN) {
+    close(fd);
+    return false;
+  }
+  m = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); // the mapping keeps the file
+  if (m == MAP_FAILED)
+    return false;
+  map  = (const uint8_t *)m;
+  size = st.st_size;
+
+  version = map[3];
+  if (map[0] != 'N' || map[1] != 'D' || map[2] != 'S')
+    version = 0;
+  if (version == NDM_STREAM_VERSION) {
+    entries   = Le(map + 4, 2);
+    end       = Le(map + 6, 2);
+    index_end = NDM_STREAM_COMMANDS(entries);
+  } else if (version == NDM_STREAM_VERSION_WIDE && size >= NDM_STREAM_WIDE_HEADER_LEN) {
+    entries   = Le(map + 4, 4);
+    end       = Le(map + 8, 8);
+    index_end = NDM_STREAM_WIDE_HEADER_LEN + entries * NDM_STREAM_WIDE_ENTRY_LEN;
+  } else {
+    Close();
+    return false;
+  }
+
+  // the index and the commands have to be there. the entries themselves
+  // are only looked at as they're played
+  if (index_end > end || end > size) {
+    Close();
+    return false;
+  }
+  next = 0;
+  return true;
+}
+
+void NdmStreamFile::Close(void) {
+  if (map)
+    munmap((void *)map, size);
+  map = 0;
+  size = entries = next = end = 0;
+}
+
+uint64_t NdmStreamFile::Entry(uint64_t n) {
+  // where entry n is in the index
+  if (version == NDM_STREAM_VERSION)
+    return NDM_STREAM_HEADER_LEN + n * NDM_STREAM_ENTRY_LEN;
+  return NDM_STREAM_WIDE_HEADER_LEN + n * NDM_STREAM_WIDE_ENTRY_LEN;
+}
+
+uint32_t NdmStreamFile::Time(uint64_t n) {
+  return Le(map + Entry(n), 4);
+}
+
+uint64_t NdmStreamFile::Offset(uint64_t n) {
+  // start of entry n's commands. the one past the last is the end
+  if (n >= entries)
+    return end;
+  return Le(map + Entry(n) + 5, version == NDM_STREAM_VERSION ? 2 : 8);
+}
+
+void NdmStreamFile::Seek(uint32_t ms) {
+  // binary search the index
+  uint64_t lo = 0, hi = entries, mid;
+
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (Time(mid) < ms)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  next = lo;
+}
+
+bool NdmStreamFile::Play(uint32_t ms, ndm_stream_send send, void *arg) {
+  //
+  // Call with the time since the stream started. Each entry that's due
+  // goes to send() as it lies in the file. One whose offsets are out of
+  // order or past the end stops the stream
+  //
+  uint64_t off, to;
+
+  while (next < entries && Time(next) <= ms) {
+    off = Offset(next);
+    to  = Offset(next + 1);
+    if (off > to || to > end) {
+      next = entries;
+      break;
+    }
+    send(map[Entry(next) + 4], map + off, to - off, arg);
+    next++;
+  }
+  return next < entries;
+}
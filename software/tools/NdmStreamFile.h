@@ -0,0 +1,60 @@
+/*
+  Command streams from a file, for a driver on a Linux host
+
+  The layout is the one in NovaDotMatrixDriver.h, NDM_STREAM_VERSION or
+  NDM_STREAM_VERSION_WIDE. Open() maps the file and looks at the header
+  and nothing else, so it takes the same time for any size. Seek() is a
+  binary search of the index. Play() hands each entry's commands to the
+  send function where they lie in the mapping, without copying them, and
+  only the pages touched come in off the disk.
+
+    NdmStreamFile s;
+    s.Open("loop.nds");
+    s.Seek(0);
+    while (s.Play(millis() - start, Send, drivers))
+      ...
+
+  Send gets the panel, the commands and how many. NdmStreamWrite() puts
+  them out through a driver.
+*/
+
+#ifndef NdmStreamFile_h
+#define NdmStreamFile_h
+#include <stdint.h>
+#include "NovaDotMatrixDriver.h"
+
+typedef void (*ndm_stream_send)(uint8_t, const uint8_t *, uint64_t, void *); // panel, commands, length, arg
+
+class NdmStreamFile {
+  public:
+    NdmStreamFile(void);
+    ~NdmStreamFile(void);
+    bool Open(const char *); // false if it can't be mapped or isn't a stream
+    void Close(void);
+
+    void Seek(uint32_t);     // next to play is the first at or after ms
+    bool Play(uint32_t, ndm_stream_send, void *); // send everything due by ms. false when done
+
+    uint64_t entries;
+    uint32_t Time(uint64_t); // ms of an entry
+    uint64_t size;           // of the file
+
+  private:
+    const uint8_t *map;
+    uint8_t version;
+    uint64_t next, end;
+    uint64_t Offset(uint64_t);
+    uint64_t Entry(uint64_t);
+};
+
+inline void NdmStreamWrite(NovaDotMatrixDriver &d, const uint8_t *p, uint64_t len) {
+  // WriteBuf() takes 255 at a time, and only reads them
+  while (len) {
+    uint8_t n = len > 255 ? 255 : len;
+    d.WriteBuf((uint8_t *)p, n);
+    p   += n;
+    len -= n;
+  }
+}
+
+#endif // NdmStreamFile_h
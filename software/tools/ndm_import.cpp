@@ -0,0 +1,732 @@
+/*
+  ndm_import: pictures and text to a command stream
+
+    ndm_import [options] input...
+
+  Each input is a GIF (every frame, with its own delays), a PBM (P1 or
+  P4), or anything else as text, a character a frame. Pictures are cut
+  into 5x7 frames:
+
+    5 wide, a multiple of 7 high   a frame per 7 rows, top down
+    7 high, wider than 5           scrolled across a column at a time
+    anything else                  scaled down to one frame
+
+  GIF frames are always scaled. Each frame goes out the cheapest way
+  there is: a plain character when it's one of the font's glyphs, or
+  whatever NovaDotMatrixDriver::WriteFrame() sends, which covers a frame
+  that's the last one moved along a column (ndotm_cmd_data_scroll), a
+  few changed columns, and a whole new frame. The result is a command
+  stream in the format NovaDotMatrixDriver::StreamPlay() plays (see
+  NovaDotMatrixDriver.h), then how many bytes it took and how long they
+  take on the wire. Past 64KB it's NDM_STREAM_VERSION_WIDE, for a host
+  to play with NdmStreamFile.
+
+  Options
+    -o file   write the stream. A name ending .h gets a PROGMEM array
+    -n name   the array's name, default stream
+    -p panel  panel for every entry, default all of them
+    -d ms     time per frame. default 500 for text, 100 for pictures,
+              and a GIF's own delays
+    -t level  0..255, brighter than this is lit. default 128
+    -D        dither instead
+    -i        invert
+    -s hz     estimate wire time for LinkSPI at hz, not bit banged
+
+  Built on the host harness, see ../host/README.md. The driver clocks
+  its bytes out to nowhere in simulated time and they're read back off
+  the pins.
+*/
+
+#include <stdio.h>
+#include <vector>
+#include "Arduino.h"
+#include "HostSim.h"
+#include "NovaDotMatrixCommands.h"
+#include "NovaDotMatrixDriver.h"
+#include "FontAlphaNum57.h"
+
+#define IMPORT_CLK_PIN 10
+#define IMPORT_DAT_PIN 11
+
+#define IMPORT_TEXT_MS    500
+#define IMPORT_PICTURE_MS 100
+
+struct picture {
+  int w, h;
+  std::vector<uint8_t> grey; // row by row, 255 is lit
+  uint32_t ms;               // 0 for -d or the default
+};
+
+struct frame {
+  uint8_t dat[NDM_NUMCOLS]; // as ndotm_cmd_data: dat[0] the left column, bit 6 the top row
+  uint32_t ms;
+};
+
+static int threshold = 128;
+static bool dither, invert;
+static uint32_t frame_ms;
+
+/*
+  reading pictures
+*/
+
+static bool ReadFile(const char *path, std::vector<uint8_t> &out) {
+  FILE *f = fopen(path, "rb");
+  uint8_t chunk[4096];
+  size_t n;
+
+  if (!f)
+    return false;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+    out.insert(out.end(), chunk, chunk + n);
+  fclose(f);
+  return true;
+}
+
+static int PbmNumber(const std::vector<uint8_t> &d, size_t &pos) {
+  // next decimal number, past white space and comments
+  int n = -1;
+
+  while (pos < d.size()) {
+    if (d[pos] == '#') {
+      while (pos < d.size() && d[pos] != '\n')
+        pos++;
+    } else if (d[pos] >= '0' && d[pos] <= '9') {
+      break;
+    } else {
+      pos++;
+    }
+  }
+  while (pos < d.size() && d[pos] >= '0' && d[pos] <= '9') {
+    n = (n < 0 ? 0 : n * 10) + d[pos++] - '0';
+    if (n > 0xffff)
+      return -1;
+  }
+  return n;
+}
+
+static bool LoadPbm(const std::vector<uint8_t> &d, picture &pic) {
+  // P1 is 0s and 1s as text, P4 packed 8 a byte, msb first. 1 is ink, lit
+  size_t pos = 2;
+  bool raw = d[1] == '4';
+  int x, y;
+
+  pic.w = PbmNumber(d, pos);
+  pic.h = PbmNumber(d, pos);
+  if (pic.w <= 0 || pic.h <= 0)
+    return false;
+  pic.grey.assign(pic.w * pic.h, 0);
+  pic.ms = 0;
+
+  if (raw) {
+    size_t stride = (pic.w + 7) / 8;
+    pos++; // the one white space after the height
+    if (d.size() < pos + stride * pic.h)
+      return false;
+    for (y = 0; y < pic.h; y++) {
+      for (x = 0; x < pic.w; x++) {
+        if (d[pos + y * stride + x / 8] & (0x80 >> (x & 7)))
+          pic.grey[y * pic.w + x] = 255;
+      }
+    }
+    return true;
+  }
+
+  for (int i = 0; i < pic.w * pic.h; i++) {
+    while (pos < d.size() && d[pos] != '0' && d[pos] != '1') {
+      if (d[pos] == '#') {
+        while (pos < d.size() && d[pos] != '\n')
+          pos++;
+      } else {
+        pos++;
+      }
+    }
+    if (pos >= d.size())
+      return false;
+    pic.grey[i] = (d[pos++] == '1') ? 255 : 0;
+  }
+  return true;
+}
+
+static bool GifUnpack(const uint8_t *code, size_t len, int min_size, std::vector<uint8_t> &out, size_t want) {
+  //
+  // LZW, codes packed lsb first. The table is a prefix code and a last
+  // byte per entry, so each string comes out backwards onto a stack
+  //
+  static uint16_t prefix[4096];
+  static uint8_t suffix[4096], stack[4097];
+  int clear = 1 << min_size, size = min_size + 1, next = clear + 2;
+  int prev = -1, first = 0, c, in, sp;
+  uint32_t bits = 0;
+  int nbits = 0;
+  size_t pos = 0;
+
+  if (min_size < 2 || min_size > 8)
+    return false;
+  for (c = 0; c < clear; c++)
+    suffix[c] = c;
+
+  while (out.size() < want) {
+    while (nbits < size && pos < len) {
+      bits |= (uint32_t)code[pos++] << nbits;
+      nbits += 8;
+    }
+    if (nbits < size)
+      break; // ran out. keep what we have
+    in = bits & ((1 << size) - 1);
+    bits >>= size;
+    nbits -= size;
+
+    if (in == clear) {
+      size = min_size + 1;
+      next = clear + 2;
+      prev = -1;
+      continue;
+    }
+    if (in == clear + 1)
+      break;
+    if (prev < 0) {
+      if (in >= clear)
+        return false;
+      out.push_back(in);
+      prev = first = in;
+      continue;
+    }
+    if (in > next)
+      return false;
+
+    sp = 0;
+    c = in;
+    if (in == next) {
+      // the string we're about to add: prev's, and its own first byte
+      stack[sp++] = first;
+      c = prev;
+    }
+    while (c >= clear) {
+      stack[sp++] = suffix[c];
+      c = prefix[c];
+    }
+    stack[sp++] = first = c;
+    while (sp)
+      out.push_back(stack[--sp]);
+
+    if (next < 4096) {
+      prefix[next] = prev;
+      suffix[next] = first;
+      next++;
+      if (next == (1 << size) && size < 12)
+        size++;
+    }
+    prev = in;
+  }
+  if (out.size() > want)
+    out.resize(want);
+  return true;
+}
+
+static bool LoadGif(const std::vector<uint8_t> &d, std::vector<picture> &pics) {
+  //
+  // each image is drawn on the screen, and the screen as it is then
+  // is a picture. Disposal is honoured, the background is dark
+  //
+  size_t pos = 13, len = d.size();
+  int w, h, i, x, y;
+  uint8_t gct[256], lct[256], *ct;
+  int transparent = -1, disposal = 0;
+  uint32_t delay_ms = 0;
+  std::vector<uint8_t> screen, saved;
+
+  if (len < 13)
+    return false;
+  w = d[6] | (d[7] << 8);
+  h = d[8] | (d[9] << 8);
+  if (!w || !h)
+    return false;
+  screen.assign(w * h, 0);
+  memset(gct, 0, sizeof(gct));
+  memset(lct, 0, sizeof(lct));
+
+  // colours straight to grey
+  if (d[10] & 0x80) {
+    int n = 2 << (d[10] & 7);
+    if (len < pos + 3 * n)
+      return false;
+    for (i = 0; i < n; i++, pos += 3)
+      gct[i] = (d[pos] * 299 + d[pos + 1] * 587 + d[pos + 2] * 114) / 1000;
+  }
+
+  while (pos < len) {
+    uint8_t block = d[pos++];
+
+    if (block == 0x3b)
+      break; // trailer
+
+    if (block == 0x21) {
+      // extension. only the graphic control one matters
+      if (pos + 1 >= len)
+        return false;
+      if (d[pos] == 0xf9 && d[pos + 1] == 4 && pos + 6 < len) {
+        disposal    = (d[pos + 2] >> 2) & 7;
+        delay_ms    = (d[pos + 3] | (d[pos + 4] << 8)) * 10;
+        transparent = (d[pos + 2] & 1) ? d[pos + 5] : -1;
+      }
+      pos++;
+      while (pos < len && d[pos])
+        pos += d[pos] + 1;
+      pos++;
+      continue;
+    }
+
+    if (block != 0x2c || pos + 9 > len)
+      return false;
+
+    int ix = d[pos] | (d[pos + 1] << 8);
+    int iy = d[pos + 2] | (d[pos + 3] << 8);
+    int iw = d[pos + 4] | (d[pos + 5] << 8);
+    int ih = d[pos + 6] | (d[pos + 7] << 8);
+    uint8_t flags = d[pos + 8];
+    pos += 9;
+    ct = gct;
+    if (flags & 0x80) {
+      int n = 2 << (flags & 7);
+      if (len < pos + 3 * n)
+        return false;
+      for (i = 0; i < n; i++, pos += 3)
+        lct[i] = (d[pos] * 299 + d[pos + 1] * 587 + d[pos + 2] * 114) / 1000;
+      ct = lct;
+    }
+    if (pos >= len)
+      return false;
+
+    // gather the sub blocks and unpack
+    int min_size = d[pos++];
+    std::vector<uint8_t> code, idx;
+    while (pos < len && d[pos]) {
+      if (pos + 1 + d[pos] > len)
+        return false;
+      code.insert(code.end(), d.begin() + pos + 1, d.begin() + pos + 1 + d[pos]);
+      pos += d[pos] + 1;
+    }
+    pos++;
+    if (!GifUnpack(code.data(), code.size(), min_size, idx, (size_t)iw * ih))
+      return false;
+
+    if (disposal == 3)
+      saved = screen;
+    for (i = 0; i < (int)idx.size(); i++) {
+      int row = i / iw;
+      if (flags & 0x40) {
+        // interlaced: every 8th from 0, every 8th from 4, every 4th from 2, every 2nd from 1
+        int n0 = (ih + 7) / 8, n1 = (ih + 3) / 8, n2 = (ih + 1) / 4;
+        if (row < n0)
+          row = row * 8;
+        else if (row < n0 + n1)
+          row = (row - n0) * 8 + 4;
+        else if (row < n0 + n1 + n2)
+          row = (row - n0 - n1) * 4 + 2;
+        else
+          row = (row - n0 - n1 - n2) * 2 + 1;
+      }
+      x = ix + i % iw;
+      y = iy + row;
+      if (x < w && y < h && idx[i] != transparent)
+        screen[y * w + x] = ct[idx[i]];
+    }
+
+    picture pic;
+    pic.w    = w;
+    pic.h    = h;
+    pic.grey = screen;
+    pic.ms   = delay_ms;
+    pics.push_back(pic);
+
+    if (disposal == 2) {
+      for (y = iy; y < iy + ih && y < h; y++) {
+        for (x = ix; x < ix + iw && x < w; x++)
+          screen[y * w + x] = 0;
+      }
+    } else if (disposal == 3) {
+      screen = saved;
+    }
+    transparent = -1;
+    disposal    = 0;
+    delay_ms    = 0;
+  }
+  return !pics.empty();
+}
+
+/*
+  pictures to frames
+*/
+
+static void Cut(const picture &pic, int x0, int y0, int w, int h, frame &f) {
+  // average each dot's share of the box, then threshold or dither it
+  float level[NDM_NUMROWS][NDM_NUMCOLS];
+  int r, c, x, y;
+
+  for (r = 0; r < NDM_NUMROWS; r++) {
+    for (c = 0; c < NDM_NUMCOLS; c++) {
+      int xa = x0 + c * w / NDM_NUMCOLS, xb = x0 + (c + 1) * w / NDM_NUMCOLS;
+      int ya = y0 + r * h / NDM_NUMROWS, yb = y0 + (r + 1) * h / NDM_NUMROWS;
+      uint32_t sum = 0, n = 0;
+      if (xb == xa)
+        xb++;
+      if (yb == ya)
+        yb++;
+      for (y = ya; y < yb && y < pic.h; y++) {
+        for (x = xa; x < xb && x < pic.w; x++, n++)
+          sum += pic.grey[y * pic.w + x];
+      }
+      level[r][c] = n ? (float)sum / n : 0;
+      if (invert)
+        level[r][c] = 255 - level[r][c];
+    }
+  }
+
+  memset(f.dat, 0, sizeof(f.dat));
+  for (r = 0; r < NDM_NUMROWS; r++) {
+    for (c = 0; c < NDM_NUMCOLS; c++) {
+      bool lit = level[r][c] > threshold;
+      if (lit)
+        f.dat[c] |= 1 << (NDM_NUMROWS - 1 - r);
+      if (!dither)
+        continue;
+      // Floyd-Steinberg, what's left over goes on to the dots not done yet
+      float err = level[r][c] - (lit ? 255 : 0);
+      if (c + 1 < NDM_NUMCOLS)
+        level[r][c + 1] += err * 7 / 16;
+      if (r + 1 < NDM_NUMROWS) {
+        if (c > 0)
+          level[r + 1][c - 1] += err * 3 / 16;
+        level[r + 1][c] += err * 5 / 16;
+        if (c + 1 < NDM_NUMCOLS)
+          level[r + 1][c + 1] += err * 1 / 16;
+      }
+    }
+  }
+}
+
+static void PictureFrames(const picture &pic, bool scale, uint32_t ms, std::vector<frame> &frames) {
+  frame f;
+
+  f.ms = frame_ms ? frame_ms : pic.ms ? pic.ms : ms;
+  if (!scale && pic.w == NDM_NUMCOLS && pic.h % NDM_NUMROWS == 0) {
+    for (int y = 0; y < pic.h; y += NDM_NUMROWS) {
+      Cut(pic, 0, y, NDM_NUMCOLS, NDM_NUMROWS, f);
+      frames.push_back(f);
+    }
+  } else if (!scale && pic.h == NDM_NUMROWS && pic.w > NDM_NUMCOLS) {
+    for (int x = 0; x + NDM_NUMCOLS <= pic.w; x++) {
+      Cut(pic, x, 0, NDM_NUMCOLS, NDM_NUMROWS, f);
+      frames.push_back(f);
+    }
+  } else {
+    Cut(pic, 0, 0, pic.w, pic.h, f);
+    frames.push_back(f);
+  }
+}
+
+static uint8_t Reverse7(uint8_t b) {
+  uint8_t r = 0;
+
+  for (uint8_t i = 0; i < NDM_NUMROWS; i++, b >>= 1)
+    r = (r << 1) | (b & 1);
+  return r;
+}
+
+static void GlyphFrame(uint8_t ch, frame &f) {
+  // font columns are left to right with bit 0 the top row
+  for (uint8_t i = 0; i < NDM_NUMCOLS; i++)
+    f.dat[i] = Reverse7(pgm_read_byte(font_5x7_2 + (ch - ' ') * NDM_NUMCOLS + i));
+}
+
+static void TextFrames(const uint8_t *s, size_t len, std::vector<frame> &frames) {
+  // a character a frame. a new line shows as a blank
+  frame f;
+
+  f.ms = frame_ms ? frame_ms : IMPORT_TEXT_MS;
+  for (size_t i = 0; i < len; i++) {
+    if (s[i] == '\n')
+      GlyphFrame(' ', f);
+    else if (s[i] >= ' ' && s[i] <= '~')
+      GlyphFrame(s[i], f);
+    else
+      continue;
+    frames.push_back(f);
+  }
+}
+
+static uint8_t GlyphFor(const frame &f) {
+  // the printable character that looks like this frame, or 0
+  frame g;
+
+  for (uint8_t ch = ' '; ch <= '~'; ch++) {
+    GlyphFrame(ch, g);
+    if (!memcmp(g.dat, f.dat, NDM_NUMCOLS))
+      return ch;
+  }
+  return 0;
+}
+
+/*
+  frames to commands
+*/
+
+static std::vector<uint8_t> wire; // bytes read back off the pins
+static bool wire_on;
+static uint8_t wire_bits, wire_byte;
+
+static void WirePin(uint8_t pin, uint8_t val) {
+  // a byte is 8 rising clocks, data msb first
+  if (!wire_on || pin != IMPORT_CLK_PIN || !val)
+    return;
+  wire_byte = (wire_byte << 1) | host_pin[IMPORT_DAT_PIN];
+  if (++wire_bits == 8) {
+    wire.push_back(wire_byte);
+    wire_bits = 0;
+  }
+}
+
+enum import_kind { kind_unchanged, kind_char, kind_scroll, kind_data, kind_other, kind_max };
+static const char *kind_name[kind_max] = { "unchanged", "char", "scroll", "data", "cols/pixels" };
+
+struct entry {
+  uint32_t ms;
+  size_t start, len; // of its commands in wire
+};
+
+static uint8_t Encode(NovaDotMatrixDriver &d, const frame &f, bool &noflip_sent, bool &showing_char, const frame &last) {
+  //
+  // The font is drawn left to right with bit 0 the top row, and raw data
+  // sets the board upside down so its bit 6 is the top (NDOTM_DATA_DONE).
+  // A character only looks like the frame right way up, so it needs an
+  // ndotm_cmd_noflip after any data
+  //
+  uint8_t ch = GlyphFor(f), cost, sent;
+  size_t was = wire.size();
+
+  if (showing_char && !memcmp(f.dat, last.dat, NDM_NUMCOLS))
+    return kind_unchanged;
+
+  // what WriteFrame() would take, from a copy
+  NovaDotMatrixDriver trial = d;
+  wire_on = false;
+  cost = trial.WriteFrame((uint8_t *)f.dat);
+  wire_on = true;
+
+  if (ch) {
+    uint8_t ch_cost = (ch == ndotm_cmd_escape_code ? 3 : 1) + (noflip_sent ? 0 : 2);
+    if (ch_cost < cost) {
+      if (!noflip_sent) {
+        d.Write(ndotm_cmd_escape_code);
+        d.Write(ndotm_cmd_noflip);
+        noflip_sent = true;
+      }
+      if (ch == ndotm_cmd_escape_code) {
+        d.Write(ndotm_cmd_escape_code);
+        d.Write(ndotm_cmd_char);
+      }
+      d.Write(ch);
+      d.ForgetFrame();
+      showing_char = true;
+      return kind_char;
+    }
+  }
+
+  sent = d.WriteFrame((uint8_t *)f.dat);
+  if (!sent)
+    return kind_unchanged;
+  noflip_sent = showing_char = false;
+  if (wire[was] == ndotm_cmd_escape_code && wire[was + 1] == ndotm_cmd_data_scroll)
+    return kind_scroll;
+  if (sent == NDM_FULL_FRAME_BYTES && wire[was + 1] == ndotm_cmd_data)
+    return kind_data;
+  return kind_other;
+}
+
+static void PutLe(std::vector<uint8_t> &s, uint64_t v, uint8_t len) {
+  while (len--) {
+    s.push_back(v & 0xff);
+    v >>= 8;
+  }
+}
+
+static uint64_t CommandsStart(size_t entries, bool &wide) {
+  // where the commands go, after the header and index
+  uint64_t start = NDM_STREAM_COMMANDS(entries);
+
+  wide = entries > 0xffff || start + wire.size() > 0xffff;
+  if (wide)
+    start = NDM_STREAM_WIDE_HEADER_LEN + (uint64_t)entries * NDM_STREAM_WIDE_ENTRY_LEN;
+  return start;
+}
+
+static bool Save(const char *path, const char *name, const std::vector<entry> &entries, uint8_t panel) {
+  //
+  // NDM_STREAM_VERSION when it fits, so it can go in a sketch, and
+  // NDM_STREAM_VERSION_WIDE for a host to play when it doesn't
+  //
+  std::vector<uint8_t> s;
+  size_t i, k = strlen(path);
+  uint64_t start, end;
+  bool sketch = k > 2 && !strcmp(path + k - 2, ".h");
+  bool wide;
+  FILE *out;
+
+  start = CommandsStart(entries.size(), wide);
+  if (wide && sketch) {
+    fprintf(stderr, "ndm_import: too big for a sketch, offsets are 16 bits. split the input\n");
+    return false;
+  }
+  end = start + wire.size();
+
+  s.push_back('N');
+  s.push_back('D');
+  s.push_back('S');
+  s.push_back(wide ? NDM_STREAM_VERSION_WIDE : NDM_STREAM_VERSION);
+  PutLe(s, entries.size(), wide ? 4 : 2);
+  PutLe(s, end, wide ? 8 : 2);
+  for (i = 0; i < entries.size(); i++) {
+    PutLe(s, entries[i].ms, 4);
+    s.push_back(panel);
+    PutLe(s, start + entries[i].start, wide ? 8 : 2);
+  }
+  s.insert(s.end(), wire.begin(), wire.end());
+
+  if (!(out = fopen(path, "wb"))) {
+    perror(path);
+    return false;
+  }
+  if (sketch) {
+    fprintf(out, "// made by ndm_import, play with NovaDotMatrixDriver::StreamStart()\n");
+    fprintf(out, "const PROGMEM uint8_t %s[] = {", name);
+    for (i = 0; i < s.size(); i++)
+      fprintf(out, "%s0x%02x,", (i % 12) ? " " : "\n  ", s[i]);
+    fprintf(out, "\n};\n");
+  } else {
+    fwrite(s.data(), 1, s.size(), out);
+  }
+  fclose(out);
+  return true;
+}
+
+static void Usage(void) {
+  fprintf(stderr, "usage: ndm_import [-o file] [-n name] [-p panel] [-d ms] [-t level] [-D] [-i] [-s hz] input...\n");
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  const char *out_path = 0, *name = "stream";
+  uint8_t panel = NDM_STREAM_ALL_PANELS;
+  uint32_t spi_hz = 0;
+  std::vector<frame> frames;
+  int i;
+
+  for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1]; i++) {
+    char opt = argv[i][1];
+    if (opt == 'D') {
+      dither = true;
+      continue;
+    }
+    if (opt == 'i') {
+      invert = true;
+      continue;
+    }
+    if (i + 1 >= argc)
+      Usage();
+    const char *arg = argv[++i];
+    switch (opt) {
+      case 'o': out_path  = arg; break;
+      case 'n': name      = arg; break;
+      case 'p': panel     = atoi(arg); break;
+      case 'd': frame_ms  = atol(arg); break;
+      case 't': threshold = atoi(arg); break;
+      case 's': spi_hz    = atol(arg); break;
+      default:  Usage();
+    }
+  }
+  if (i == argc)
+    Usage();
+
+  for (; i < argc; i++) {
+    std::vector<uint8_t> d;
+    std::vector<picture> pics;
+    picture pic;
+
+    if (!ReadFile(argv[i], d)) {
+      perror(argv[i]);
+      return 1;
+    }
+    if (d.size() >= 6 && (!memcmp(d.data(), "GIF87a", 6) || !memcmp(d.data(), "GIF89a", 6))) {
+      if (!LoadGif(d, pics)) {
+        fprintf(stderr, "ndm_import: %s: can't read this GIF\n", argv[i]);
+        return 1;
+      }
+      for (size_t k = 0; k < pics.size(); k++)
+        PictureFrames(pics[k], true, IMPORT_PICTURE_MS, frames);
+    } else if (d.size() >= 2 && d[0] == 'P' && (d[1] == '1' || d[1] == '4')) {
+      if (!LoadPbm(d, pic)) {
+        fprintf(stderr, "ndm_import: %s: can't read this PBM\n", argv[i]);
+        return 1;
+      }
+      PictureFrames(pic, false, IMPORT_PICTURE_MS, frames);
+    } else {
+      TextFrames(d.data(), d.size(), frames);
+    }
+  }
+
+  // drive a board that isn't there, and read what it would have got
+  NovaDotMatrixDriver d, est;
+  std::vector<entry> entries;
+  uint32_t kinds[kind_max] = { 0 }, ms = 0, late = 0;
+  bool noflip_sent = false, showing_char = false, wide;
+  frame last;
+
+  HostReset();
+  memset(&d, 0, sizeof(d));
+  d.clk_pin  = IMPORT_CLK_PIN;
+  d.data_pin = IMPORT_DAT_PIN;
+  d.Setup();
+  host_pin_hook = WirePin;
+  wire_on = true;
+  memset(&last, 0, sizeof(last));
+  est = d;
+  if (spi_hz) {
+    est.link   = NovaDotMatrixDriver::LinkSPI;
+    est.spi_hz = spi_hz;
+  }
+
+  for (size_t k = 0; k < frames.size(); k++) {
+    entry e;
+    e.ms    = ms;
+    e.start = wire.size();
+    kinds[Encode(d, frames[k], noflip_sent, showing_char, last)]++;
+    e.len = wire.size() - e.start;
+    if (e.len) {
+      entries.push_back(e);
+      if (est.WireMicros(e.len) > frames[k].ms * 1000UL)
+        late++;
+    }
+    last = frames[k];
+    ms  += frames[k].ms;
+  }
+  host_pin_hook = 0;
+
+  // the report
+  printf("%lu frames, %lu.%03lu s\n", (unsigned long)frames.size(), (unsigned long)(ms / 1000), (unsigned long)(ms % 1000));
+  for (i = 0; i < kind_max; i++)
+    printf("  %-12s %lu\n", kind_name[i], (unsigned long)kinds[i]);
+  printf("%lu bytes of commands, %lu with the index\n", (unsigned long)wire.size(),
+      (unsigned long)(CommandsStart(entries.size(), wide) + wire.size()));
+  printf("%lu ms on the wire at %lu us a byte", (unsigned long)(est.WireMicros(wire.size()) / 1000),
+      (unsigned long)est.WireMicros(1));
+  if (ms)
+    printf(", %lu%% of the running time", (unsigned long)(est.WireMicros(wire.size()) / 10 / ms));
+  printf("\n");
+  if (late)
+    printf("%lu frames take longer to send than they show for\n", (unsigned long)late);
+
+  if (out_path && !Save(out_path, name, entries, panel))
+    return 1;
+  return 0;
+}